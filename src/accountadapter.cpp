@@ -23,6 +23,7 @@
 #include "appsettingsmanager.h"
 #include "qtutils.h"
 #include "qmlregister.h"
+#include "base64.h"
 
 #include <QtConcurrent/QtConcurrent>
 
@@ -289,7 +290,7 @@ AccountAdapter::setCurrentAccountAvatarFile(const QString& source)
         QBuffer bu(&ba);
         bu.open(QIODevice::WriteOnly);
         image.save(&bu, "PNG");
-        auto str = QString::fromLocal8Bit(ba.toBase64());
+        auto str = Base64::encodeToString(ba);
         auto accountId = lrcInstance_->get_currentAccountId();
         lrcInstance_->accountModel().setAvatar(accountId, str);
     });
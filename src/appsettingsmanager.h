@@ -51,6 +51,10 @@ extern const QString defaultDownloadPath;
     X(NeverShowMeAgain, false) \
     X(WindowGeometry, QRectF(qQNaN(), qQNaN(), 0., 0.)) \
     X(WindowState, QWindow::AutomaticVisibility) \
+    X(VideoFramePoolSize, 3) \
+    X(VideoPixelFormat, "RGBA") \
+    X(VideoMemoryBudget, 256) \
+    X(AvatarCacheSize, 64) \
     X(LANG, "SYSTEM")
 
 /*
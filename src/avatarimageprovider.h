@@ -20,6 +20,7 @@
 #pragma once
 
 #include "quickimageproviderbase.h"
+#include "imagecache.h"
 #include "utils.h"
 #include "lrcinstance.h"
 
@@ -28,10 +29,11 @@
 class AvatarImageProvider : public QuickImageProviderBase
 {
 public:
-    AvatarImageProvider(LRCInstance* instance = nullptr)
+    AvatarImageProvider(LRCInstance* instance = nullptr, ImageCache* cache = nullptr)
         : QuickImageProviderBase(QQuickImageProvider::Image,
                                  QQmlImageProviderBase::ForceAsynchronousImageLoading,
                                  instance)
+        , cache_(cache)
     {}
 
     QImage requestImage(const QString& id, QSize* size, const QSize& requestedSize) override
@@ -43,6 +45,31 @@ public:
             return {};
         }
 
+        auto key = cacheKey(id, requestedSize);
+        if (cache_ && !key.isEmpty()) {
+            auto image = cache_->find(key);
+            if (!image.isNull())
+                return image;
+        }
+
+        auto image = loadImage(lrcInstance_, id, requestedSize);
+        if (cache_ && !key.isEmpty())
+            cache_->insert(key, image);
+        return image;
+    }
+
+    // The uid changes whenever the image data does, so the url and the
+    // requested size identify the final image. Empty for urls without uid.
+    static QString cacheKey(const QString& id, const QSize& requestedSize)
+    {
+        if (id.count('_') < 2)
+            return {};
+        return QString("%1_%2x%3").arg(id).arg(requestedSize.width()).arg(requestedSize.height());
+    }
+
+    // May be called from any thread.
+    static QImage loadImage(LRCInstance* instance, const QString& id, const QSize& requestedSize)
+    {
         // the first string is the item uri and the second is a uid
         // that is used for trigger a reload of the underlying image
         // data and can be discarded at this point
@@ -64,13 +91,16 @@ public:
             if (imageId == "temp")
                 return Utils::tempConversationAvatar(requestedSize);
 
-            return Utils::conversationAvatar(lrcInstance_, imageId, requestedSize);
+            return Utils::conversationAvatar(instance, imageId, requestedSize);
         } else if (type == "account")
-            return Utils::accountPhoto(lrcInstance_, imageId, requestedSize);
+            return Utils::accountPhoto(instance, imageId, requestedSize);
         else if (type == "contact")
-            return Utils::contactPhoto(lrcInstance_, imageId, requestedSize);
+            return Utils::contactPhoto(instance, imageId, requestedSize);
 
         qWarning() << Q_FUNC_INFO << "Missing valid prefix in the image url";
         return {};
     }
+
+private:
+    ImageCache* cache_ {nullptr};
 };
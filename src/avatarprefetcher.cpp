@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2022 Savoir-faire Linux Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "avatarprefetcher.h"
+
+#include "avatarimageprovider.h"
+#include "imagecache.h"
+
+namespace {
+// Decoding is left some headroom next to QML's own image loading.
+constexpr int kMaxWorkers = 2;
+} // namespace
+
+AvatarPrefetcher::AvatarPrefetcher(LRCInstance* instance, ImageCache* cache)
+    : lrcInstance_(instance)
+    , cache_(cache)
+{
+    pool_.setMaxThreadCount(kMaxWorkers);
+}
+
+AvatarPrefetcher::~AvatarPrefetcher()
+{
+    {
+        QMutexLocker lk(&mutex_);
+        queue_.clear();
+    }
+    pool_.waitForDone();
+}
+
+void
+AvatarPrefetcher::prefetch(const QStringList& visible, const QStringList& margin, const QSize& size)
+{
+    if (size.isEmpty()) {
+        return;
+    }
+    QMutexLocker lk(&mutex_);
+    // Requests being loaded complete, the others are replaced.
+    queue_.clear();
+    for (const auto& ids : {visible, margin}) {
+        for (const auto& id : ids) {
+            if (!cache_->contains(AvatarImageProvider::cacheKey(id, size))) {
+                queue_.push_back({id, size});
+            }
+        }
+    }
+    while (workers_ < kMaxWorkers && workers_ < static_cast<int>(queue_.size())) {
+        ++workers_;
+        pool_.start([this] { work(); });
+    }
+}
+
+void
+AvatarPrefetcher::work()
+{
+    QMutexLocker lk(&mutex_);
+    while (!queue_.empty()) {
+        auto request = queue_.front();
+        queue_.pop_front();
+        lk.unlock();
+
+        auto key = AvatarImageProvider::cacheKey(request.id, request.size);
+        if (!cache_->contains(key)) {
+            auto image = AvatarImageProvider::loadImage(lrcInstance_, request.id, request.size);
+            cache_->insert(key, image);
+        }
+
+        lk.relock();
+    }
+    --workers_;
+}
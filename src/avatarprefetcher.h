@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2022 Savoir-faire Linux Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QMutex>
+#include <QSize>
+#include <QStringList>
+#include <QThreadPool>
+
+#include <deque>
+
+class ImageCache;
+class LRCInstance;
+
+// Loads avatar images ahead of AvatarImageProvider, into the cache it
+// reads, on a small dedicated thread pool. Each call to prefetch replaces
+// the pending requests, so that rows scrolled out of view are cancelled
+// before being loaded.
+class AvatarPrefetcher
+{
+public:
+    AvatarPrefetcher(LRCInstance* instance, ImageCache* cache);
+    ~AvatarPrefetcher();
+
+    // ids are avatar image ids, as in AvatarImageProvider urls. The
+    // visible ones are loaded before the others.
+    void prefetch(const QStringList& visible, const QStringList& margin, const QSize& size);
+
+private:
+    struct Request
+    {
+        QString id;
+        QSize size;
+    };
+
+    void work();
+
+    LRCInstance* lrcInstance_;
+    ImageCache* cache_;
+    QThreadPool pool_;
+    QMutex mutex_;
+    std::deque<Request> queue_;
+    int workers_ {0};
+};
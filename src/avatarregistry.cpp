@@ -22,6 +22,7 @@
 
 AvatarRegistry::AvatarRegistry(LRCInstance* instance, QObject* parent)
     : QObject(parent)
+    , prefetcher_(instance, &imageCache_)
     , lrcInstance_(instance)
 {
     connect(lrcInstance_,
@@ -46,11 +47,11 @@ AvatarRegistry::AvatarRegistry(LRCInstance* instance, QObject* parent)
 QString
 AvatarRegistry::addOrUpdateImage(const QString& id)
 {
-    auto uid = Utils::generateUid();
+    auto uid = Utils::avatarUid(lrcInstance_, id);
     auto it = uidMap_.find(id);
     if (it == uidMap_.end()) {
         uidMap_.insert(id, uid);
-    } else {
+    } else if (it.value() != uid) {
         it.value() = uid;
         Q_EMIT avatarUidChanged(id);
     }
@@ -77,6 +78,10 @@ AvatarRegistry::connectAccount()
 void
 AvatarRegistry::onProfileUpdated(const QString& uri)
 {
+    // Contact avatars are registered by peer uri.
+    if (uidMap_.contains(uri))
+        addOrUpdateImage(uri);
+
     auto& convInfo = lrcInstance_->getConversationFromPeerUri(uri);
     if (convInfo.uid.isEmpty())
         return;
@@ -84,6 +89,21 @@ AvatarRegistry::onProfileUpdated(const QString& uri)
     addOrUpdateImage(convInfo.uid);
 }
 
+void
+AvatarRegistry::prefetchConversations(const QStringList& visible,
+                                       const QStringList& margin,
+                                       const QSize& size)
+{
+    auto imageIds = [this](const QStringList& convIds) {
+        QStringList ids;
+        ids.reserve(convIds.size());
+        for (const auto& convId : convIds)
+            ids.append(QString("conversation_%1_%2").arg(convId, getUid(convId)));
+        return ids;
+    };
+    prefetcher_.prefetch(imageIds(visible), imageIds(margin), size);
+}
+
 QString
 AvatarRegistry::getUid(const QString& id)
 {
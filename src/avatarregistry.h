@@ -18,8 +18,12 @@
 
 #pragma once
 
+#include "imagecache.h"
+#include "avatarprefetcher.h"
+
 #include <QObject>
 #include <QMap>
+#include <QSize>
 
 class LRCInstance;
 
@@ -33,9 +37,31 @@ public:
     // get a uid for an image in the cache
     Q_INVOKABLE QString getUid(const QString& id);
 
-    // add or update a specific image in the cache
+    // add or update a specific image in the cache, the uid only
+    // changes when the data the image is drawn from does
     QString addOrUpdateImage(const QString& id);
 
+    // Final avatar images served by AvatarImageProvider, keyed by the
+    // image url and requested size. Entries of a previous uid are left
+    // to age out.
+    ImageCache& imageCache()
+    {
+        return imageCache_;
+    }
+
+    // Byte size, budget, entry count, hits and misses of the image cache.
+    Q_INVOKABLE QVariantMap imageCacheStats() const
+    {
+        return imageCache_.stats();
+    }
+
+public Q_SLOTS:
+    // Loads the avatars of the given conversations ahead of the image
+    // provider, the visible ones first. size is the requested pixel size.
+    void prefetchConversations(const QStringList& visible,
+                               const QStringList& margin,
+                               const QSize& size);
+
 Q_SIGNALS:
     void avatarUidChanged(const QString& id);
 
@@ -47,5 +73,9 @@ private:
     // Used to force cache updates via QQuickImageProvider
     QMap<QString, QString> uidMap_;
 
+    ImageCache imageCache_;
+    // Declared after the cache it fills, and destroyed before it.
+    AvatarPrefetcher prefetcher_;
+
     LRCInstance* lrcInstance_;
 };
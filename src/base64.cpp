@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2022 Savoir-faire Linux Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "base64.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BASE64_SSE2
+#endif
+
+namespace {
+
+constexpr char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+constexpr int
+sextet(uint ch)
+{
+    if (ch >= 'A' && ch <= 'Z')
+        return ch - 'A';
+    if (ch >= 'a' && ch <= 'z')
+        return ch - 'a' + 26;
+    if (ch >= '0' && ch <= '9')
+        return ch - '0' + 52;
+    if (ch == '+')
+        return 62;
+    if (ch == '/')
+        return 63;
+    return -1;
+}
+
+// Writes the 3 bytes of 4 sextets.
+inline char*
+packQuad(char* out, const uchar* s)
+{
+    quint32 v = (quint32(s[0]) << 18) | (quint32(s[1]) << 12) | (quint32(s[2]) << 6) | s[3];
+    out[0] = char(v >> 16);
+    out[1] = char(v >> 8);
+    out[2] = char(v);
+    return out + 3;
+}
+
+#ifdef BASE64_SSE2
+// Translates 16 characters to sextets. Returns false, leaving sextets
+// undefined, if any of them is outside of the alphabet.
+inline bool
+translate16(__m128i chars, uchar* sextets)
+{
+    auto inRange = [&](char lo, char hi) {
+        return _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8(char(lo - 1))),
+                             _mm_cmplt_epi8(chars, _mm_set1_epi8(char(hi + 1))));
+    };
+    auto upper = inRange('A', 'Z');
+    auto lower = inRange('a', 'z');
+    auto digit = inRange('0', '9');
+    auto plus = _mm_cmpeq_epi8(chars, _mm_set1_epi8('+'));
+    auto slash = _mm_cmpeq_epi8(chars, _mm_set1_epi8('/'));
+
+    auto valid = _mm_or_si128(_mm_or_si128(upper, lower),
+                              _mm_or_si128(digit, _mm_or_si128(plus, slash)));
+    if (_mm_movemask_epi8(valid) != 0xffff)
+        return false;
+
+    // Each character gets the offset of its class added.
+    auto offset = _mm_or_si128(
+        _mm_or_si128(_mm_and_si128(upper, _mm_set1_epi8(char(-'A'))),
+                     _mm_and_si128(lower, _mm_set1_epi8(char(26 - 'a')))),
+        _mm_or_si128(_mm_and_si128(digit, _mm_set1_epi8(char(52 - '0'))),
+                     _mm_or_si128(_mm_and_si128(plus, _mm_set1_epi8(char(62 - '+'))),
+                                  _mm_and_si128(slash, _mm_set1_epi8(char(63 - '/'))))));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(sextets), _mm_add_epi8(chars, offset));
+    return true;
+}
+
+inline __m128i
+load16(const char* data)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+}
+
+// The units are packed with signed saturation to unsigned bytes: units
+// from 0x100 to 0x7fff become 0xff and units from 0x8000 become 0. Neither
+// is in the alphabet, so the scalar path handles those blocks.
+inline __m128i
+load16(const char16_t* data)
+{
+    auto lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    auto hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 8));
+    return _mm_packus_epi16(lo, hi);
+}
+#endif
+
+template<typename Char>
+QByteArray
+decodeImpl(const Char* data, qsizetype size)
+{
+    QByteArray result(size * 3 / 4, Qt::Uninitialized);
+    auto* out = result.data();
+    uchar quad[4];
+    int count = 0;
+    qsizetype i = 0;
+    while (i < size) {
+#ifdef BASE64_SSE2
+        // Whole blocks of 16 valid characters, 4 quads, while aligned on
+        // a quad boundary.
+        if (count == 0) {
+            alignas(16) uchar sextets[16];
+            while (size - i >= 16 && translate16(load16(data + i), sextets)) {
+                out = packQuad(out, sextets);
+                out = packQuad(out, sextets + 4);
+                out = packQuad(out, sextets + 8);
+                out = packQuad(out, sextets + 12);
+                i += 16;
+            }
+            if (i == size)
+                break;
+        }
+#endif
+        auto d = sextet(static_cast<uint>(data[i++]));
+        if (d < 0)
+            continue;
+        quad[count++] = uchar(d);
+        if (count == 4) {
+            out = packQuad(out, quad);
+            count = 0;
+        }
+    }
+
+    // Trailing 2 or 3 sextets carry 1 or 2 bytes.
+    if (count >= 2) {
+        quint32 v = (quint32(quad[0]) << 18) | (quint32(quad[1]) << 12);
+        if (count == 3)
+            v |= quint32(quad[2]) << 6;
+        *out++ = char(v >> 16);
+        if (count == 3)
+            *out++ = char(v >> 8);
+    }
+    result.truncate(out - result.constData());
+    return result;
+}
+
+template<typename Char>
+void
+encodeImpl(const uchar* data, qsizetype size, Char* out)
+{
+    qsizetype i = 0;
+    for (; size - i >= 3; i += 3) {
+        quint32 v = (quint32(data[i]) << 16) | (quint32(data[i + 1]) << 8) | data[i + 2];
+        *out++ = Char(kAlphabet[v >> 18]);
+        *out++ = Char(kAlphabet[(v >> 12) & 0x3f]);
+        *out++ = Char(kAlphabet[(v >> 6) & 0x3f]);
+        *out++ = Char(kAlphabet[v & 0x3f]);
+    }
+    if (size - i > 0) {
+        quint32 v = quint32(data[i]) << 16;
+        if (size - i == 2)
+            v |= quint32(data[i + 1]) << 8;
+        *out++ = Char(kAlphabet[v >> 18]);
+        *out++ = Char(kAlphabet[(v >> 12) & 0x3f]);
+        *out++ = size - i == 2 ? Char(kAlphabet[(v >> 6) & 0x3f]) : Char('=');
+        *out++ = Char('=');
+    }
+}
+
+inline qsizetype
+encodedSize(qsizetype size)
+{
+    return (size + 2) / 3 * 4;
+}
+
+} // namespace
+
+namespace Base64 {
+
+QByteArray
+decode(QByteArrayView data)
+{
+    return decodeImpl(data.data(), data.size());
+}
+
+QByteArray
+decode(QStringView data)
+{
+    return decodeImpl(data.utf16(), data.size());
+}
+
+QByteArray
+encode(QByteArrayView data)
+{
+    QByteArray result(encodedSize(data.size()), Qt::Uninitialized);
+    encodeImpl(reinterpret_cast<const uchar*>(data.data()), data.size(), result.data());
+    return result;
+}
+
+QString
+encodeToString(QByteArrayView data)
+{
+    QString result(encodedSize(data.size()), Qt::Uninitialized);
+    encodeImpl(reinterpret_cast<const uchar*>(data.data()),
+               data.size(),
+               reinterpret_cast<char16_t*>(result.data()));
+    return result;
+}
+
+} // namespace Base64
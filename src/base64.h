@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2022 Savoir-faire Linux Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QString>
+#include <QStringView>
+
+// Standard (RFC 4648) base64 codec working on UTF-16 text as well as
+// bytes, so that base64 data held in a QString is decoded without an
+// intermediate Latin-1 copy, and encoded data is written straight into
+// a QString. The decoders are lenient like QByteArray::fromBase64:
+// characters outside of the alphabet, padding included, are skipped.
+namespace Base64 {
+
+QByteArray decode(QByteArrayView data);
+QByteArray decode(QStringView data);
+
+// Padded with '='.
+QByteArray encode(QByteArrayView data);
+QString encodeToString(QByteArrayView data);
+
+} // namespace Base64
@@ -117,10 +117,7 @@ CallAdapter::onCallStatusChanged(const QString& accountId, const QString& callId
         if (systemTray_->hideNotification(QString("%1;%2").arg(accountId).arg(convInfo.uid))
             && call.startTime.time_since_epoch().count() == 0) {
             // This was a missed call; show a missed call notification
-            auto convAvatar = Utils::conversationAvatar(lrcInstance_,
-                                                        convInfo.uid,
-                                                        QSize(50, 50),
-                                                        accountId);
+            auto convAvatar = Utils::notificationAvatar(lrcInstance_, convInfo.uid, accountId);
             auto& accInfo = lrcInstance_->getAccountInfo(accountId);
             auto from = accInfo.conversationModel->title(convInfo.uid);
             auto notifId = QString("%1;%2").arg(accountId).arg(convInfo.uid);
@@ -128,7 +125,7 @@ CallAdapter::onCallStatusChanged(const QString& accountId, const QString& callId
                                           tr("Missed call"),
                                           tr("Missed call with %1").arg(from),
                                           NotificationType::CHAT,
-                                          Utils::QImageToByteArray(convAvatar));
+                                          convAvatar);
         }
     }
 #else
@@ -539,13 +536,13 @@ CallAdapter::showNotification(const QString& accountId, const QString& convUid)
     auto title = accInfo.conversationModel->title(convUid);
 
 #ifdef Q_OS_LINUX
-    auto convAvatar = Utils::conversationAvatar(lrcInstance_, convUid, QSize(50, 50), accountId);
+    auto convAvatar = Utils::notificationAvatar(lrcInstance_, convUid, accountId);
     auto notifId = QString("%1;%2").arg(accountId).arg(convUid);
     systemTray_->showNotification(notifId,
                                   tr("Incoming call"),
                                   tr("%1 is calling you").arg(title),
                                   NotificationType::CALL,
-                                  Utils::QImageToByteArray(convAvatar));
+                                  convAvatar);
 #else
     auto onClicked = [this, accountId, convUid]() {
         Q_EMIT lrcInstance_->notificationClicked();
@@ -32,6 +32,7 @@ Item {
     property alias imageId: avatar.imageId
     property bool newConversation: false
     property real avatarSize
+    property int captureRequestId: -1
 
     signal focusOnPreviousItem
     signal focusOnNextItem
@@ -51,6 +52,20 @@ Item {
         isPreviewing = false
     }
 
+    Connections {
+        target: videoProvider
+
+        function onVideoFrameCaptured(requestId, data) {
+            if (requestId !== root.captureRequestId)
+                return
+            root.captureRequestId = -1
+            if (!root.newConversation)
+                AccountAdapter.setCurrentAccountAvatarBase64(data)
+            else
+                UtilsAdapter.setSwarmCreationImageFromString(data, imageId)
+        }
+    }
+
     function focusOnNextPhotoBoothItem () {
         takePhotoButton.forceActiveFocus()
     }
@@ -146,7 +161,7 @@ Item {
                 rendererId: VideoDevices.getDefaultDevice()
 
                 function takePhoto() {
-                    return videoProvider.captureVideoFrame(videoSink)
+                    return videoProvider.captureVideoFrameAsync(videoSink, "JPEG", 90)
                 }
 
                 layer.enabled: true
@@ -226,11 +241,9 @@ Item {
                 onClicked: {
                     if (isPreviewing) {
                         flashAnimation.start()
-                        var photo = preview.takePhoto(avatarSize)
-                        if (!root.newConversation)
-                            AccountAdapter.setCurrentAccountAvatarBase64(photo)
-                        else
-                            UtilsAdapter.setSwarmCreationImageFromString(photo, imageId)
+                        // The frame is grabbed right away, the avatar is set
+                        // once encoded (see onVideoFrameCaptured).
+                        root.captureRequestId = preview.takePhoto()
                         stopBooth()
                         return
                     }
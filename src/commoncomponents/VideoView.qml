@@ -20,14 +20,23 @@ import QtQuick
 import QtMultimedia
 import Qt5Compat.GraphicalEffects
 
+import net.jami.Constants 1.1
+
 Item {
     id: root
 
     property string rendererId
     property alias videoSink: videoOutput.videoSink
     property alias underlayItems: rootUnderlayItem.children
-    property real invAspectRatio: (videoOutput.sourceRect.height
-                                   / videoOutput.sourceRect.width) ||
+    // The resolution of the stream, the frames delivered to the sink
+    // may be downscaled copies.
+    property size sourceSize: {
+        var size = videoProvider.activeRenderers[rendererId]
+        if (size !== undefined)
+            return size
+        return Qt.size(videoOutput.sourceRect.width, videoOutput.sourceRect.height)
+    }
+    property real invAspectRatio: (sourceSize.height / sourceSize.width) ||
                                   0.5625 // 16:9 default
     property bool crop: false
 
@@ -35,13 +44,20 @@ Item {
     // as the VideoOutput component may use PreserveAspectFit
     // (pillarbox/letterbox).
     property rect contentRect: videoOutput.contentRect
-    property real xScale: contentRect.width / videoOutput.sourceRect.width
-    property real yScale: contentRect.height / videoOutput.sourceRect.height
+    property real xScale: contentRect.width / sourceSize.width
+    property real yScale: contentRect.height / sourceSize.height
+
+    // The on-screen pixel size of the sink, used by the provider
+    // to deliver downscaled frames to small views.
+    property size sinkSize: Qt.size(width * CurrentScreenInfo.devicePixelRatio,
+                                    height * CurrentScreenInfo.devicePixelRatio)
+
+    onSinkSizeChanged: videoProvider.setSinkSize(videoSink, sinkSize)
 
     onRendererIdChanged: {
         videoProvider.unregisterSink(videoSink)
         if (rendererId.length !== 0) {
-            videoProvider.registerSink(rendererId, videoSink)
+            videoProvider.registerSink(rendererId, videoSink, sinkSize)
         }
     }
 
@@ -21,17 +21,98 @@
 
 #include "uri.h"
 
+#include <algorithm>
+
 ConversationListModel::ConversationListModel(LRCInstance* instance, QObject* parent)
     : ConversationListModelBase(instance, parent)
 {
     if (!model_)
         return;
 
+    // Every change is signaled through dataChanged, with the roles when
+    // they are known, so rows can be materialized. These connections
+    // come first, invalidating rows before any view reads them again.
+    rowCacheEnabled_ = true;
+    connect(this,
+            &QAbstractItemModel::dataChanged,
+            this,
+            [this](const QModelIndex& topLeft,
+                   const QModelIndex& bottomRight,
+                   const QList<int>& roles) {
+                if (!topLeft.isValid() || !bottomRight.isValid())
+                    return;
+                const auto& data = model_->getConversations();
+                auto groups = roleGroups(roles);
+                // The sort key is recomputed whatever emitted the change.
+                auto sortKeyChanged = roles.isEmpty()
+                                      || roles.contains(Role::LastInteractionTimeStamp);
+                for (int row = std::max(topLeft.row(), 0);
+                     row <= bottomRight.row() && row < data.size();
+                     ++row) {
+                    invalidateRow(data.at(row).uid, groups);
+                    if (sortKeyChanged && row < static_cast<int>(sortKeys_.size()))
+                        sortKeys_[row] = computeSortKey(data.at(row));
+                }
+                if (groups & (ConversationGroup | PeerGroup))
+                    markSearchDirty(topLeft.row(), bottomRight.row());
+            });
+    // A conversation can be removed and added again with the same uid.
+    connect(this,
+            &QAbstractItemModel::rowsInserted,
+            this,
+            [this](const QModelIndex&, int first, int last) {
+                const auto& data = model_->getConversations();
+                for (int row = first; row <= last && row < data.size(); ++row) {
+                    invalidateRow(data.at(row).uid);
+                    rowIndex_.insert(data.at(row).uid, row);
+                }
+                markSearchDirty(first, last);
+            });
+    connect(this,
+            &QAbstractItemModel::rowsAboutToBeRemoved,
+            this,
+            [this](const QModelIndex&, int first, int last) {
+                const auto& data = model_->getConversations();
+                for (int row = std::max(first, 0); row <= last && row < data.size(); ++row)
+                    invalidateRow(data.at(row).uid);
+                markSearchDirty(first, last);
+            });
+    connect(this, &QAbstractItemModel::modelReset, this, [this] {
+        clearRows();
+        sortKeys_.clear();
+        rowIndex_.clear();
+        searchIndex_.clear();
+        searchIndexed_ = false;
+        searchDirty_.clear();
+    });
+    // Call status changes only affect the call roles.
+    connect(lrcInstance_->getCurrentCallModel(),
+            &NewCallModel::callStatusChanged,
+            this,
+            [this](const QString& callId, int) {
+                const auto& convInfo = lrcInstance_->getConversationFromCallId(callId);
+                if (convInfo.uid.isEmpty())
+                    return;
+                auto row = indexOf(convInfo.uid);
+                if (row < 0)
+                    return;
+                const auto index = createIndex(row, 0);
+                Q_EMIT dataChanged(index,
+                                   index,
+                                   {Role::InCall,
+                                    Role::IsAudioOnly,
+                                    Role::CallStackViewShouldShow,
+                                    Role::CallState});
+            });
+
     connect(
         model_,
         &ConversationModel::beginInsertRows,
         this,
         [this](int position, int rows) {
+            if (position <= static_cast<int>(sortKeys_.size()))
+                sortKeys_.insert(sortKeys_.begin() + position, rows, kUnknownSortKey);
+            shiftRowIndex(position, rows);
             beginInsertRows(QModelIndex(), position, position + (rows - 1));
         },
         Qt::DirectConnection);
@@ -46,6 +127,13 @@ ConversationListModel::ConversationListModel(LRCInstance* instance, QObject* par
         &ConversationModel::beginRemoveRows,
         this,
         [this](int position, int rows) {
+            if (position + rows <= static_cast<int>(sortKeys_.size()))
+                sortKeys_.erase(sortKeys_.begin() + position,
+                                sortKeys_.begin() + position + rows);
+            const auto& data = model_->getConversations();
+            for (int row = position; row < position + rows && row < data.size(); ++row)
+                rowIndex_.remove(data.at(row).uid);
+            shiftRowIndex(position + rows, -rows);
             beginRemoveRows(QModelIndex(), position, position + (rows - 1));
         },
         Qt::DirectConnection);
@@ -57,10 +145,91 @@ ConversationListModel::ConversationListModel(LRCInstance* instance, QObject* par
 
     connect(model_, &ConversationModel::dataChanged, this, [this](int position) {
         const auto index = createIndex(position, 0);
+        // Unless the last interaction changed, leave the sort role out so
+        // that the proxy does not reposition the row. The filter role of
+        // the proxy stays in, the row is filtered again.
+        const auto& data = model_->getConversations();
+        if (position < 0 || position >= data.size()
+            || position >= static_cast<int>(sortKeys_.size())) {
+            Q_EMIT ConversationListModel::dataChanged(index, index);
+            return;
+        }
+        auto key = computeSortKey(data.at(position));
+        auto& cachedKey = sortKeys_[position];
+        if (cachedKey == key) {
+            static const QList<int> rolesButSortKey = [] {
+                QList<int> roles {Qt::DisplayRole};
+#define X(role) \
+    if (ConversationList::role != ConversationList::LastInteractionTimeStamp) \
+        roles.append(ConversationList::role);
+                CONV_ROLES
+#undef X
+                return roles;
+            }();
+            Q_EMIT ConversationListModel::dataChanged(index, index, rolesButSortKey);
+            return;
+        }
+        cachedKey = key;
         Q_EMIT ConversationListModel::dataChanged(index, index);
     });
 }
 
+qint64
+ConversationListModel::computeSortKey(const conversation::Info& item)
+{
+    if (item.interactions->empty())
+        return 0;
+    return static_cast<qint32>(item.interactions->at(item.lastMessageUid).timestamp);
+}
+
+qint64
+ConversationListModel::sortKey(int row) const
+{
+    const auto& data = model_->getConversations();
+    if (row < 0 || row >= data.size())
+        return 0;
+    if (sortKeys_.size() != static_cast<size_t>(data.size()))
+        sortKeys_.assign(data.size(), kUnknownSortKey);
+    auto& key = sortKeys_[row];
+    if (key == kUnknownSortKey)
+        key = computeSortKey(data.at(row));
+    return key;
+}
+
+int
+ConversationListModel::indexOf(const QString& uid) const
+{
+    if (!model_)
+        return -1;
+    const auto& data = model_->getConversations();
+    auto it = rowIndex_.constFind(uid);
+    if (it != rowIndex_.cend() && it.value() < data.size() && data.at(it.value()).uid == uid)
+        return it.value();
+    // A miss is only trusted when every row is indexed.
+    if (it == rowIndex_.cend() && rowIndex_.size() == data.size())
+        return -1;
+    rebuildRowIndex();
+    return rowIndex_.value(uid, -1);
+}
+
+void
+ConversationListModel::shiftRowIndex(int position, int delta)
+{
+    for (auto it = rowIndex_.begin(); it != rowIndex_.end(); ++it)
+        if (it.value() >= position)
+            it.value() += delta;
+}
+
+void
+ConversationListModel::rebuildRowIndex() const
+{
+    const auto& data = model_->getConversations();
+    rowIndex_.clear();
+    rowIndex_.reserve(data.size());
+    for (int row = 0; row < data.size(); ++row)
+        rowIndex_.insert(data.at(row).uid, row);
+}
+
 int
 ConversationListModel::rowCount(const QModelIndex& parent) const
 {
@@ -81,6 +250,53 @@ ConversationListModel::data(const QModelIndex& index, int role) const
     return dataForItem(data.at(index.row()), role);
 }
 
+bool
+ConversationListModel::matchesSearch(const QString& uid, const QString& text) const
+{
+    updateSearchIndex();
+    return searchIndex_.matches(uid, text);
+}
+
+void
+ConversationListModel::markSearchDirty(int first, int last)
+{
+    if (!searchIndexed_)
+        return;
+    const auto& data = model_->getConversations();
+    for (int row = std::max(first, 0); row <= last && row < data.size(); ++row)
+        searchDirty_.insert(data.at(row).uid);
+}
+
+void
+ConversationListModel::updateSearchIndex() const
+{
+    using namespace ConversationList;
+    auto fields = [this](const conversation::Info& item) {
+        QStringList fields;
+        fields += dataForItem(item, Role::Title).toString();
+        fields += dataForItem(item, Role::Uris).toStringList();
+        fields += dataForItem(item, Role::Monikers).toStringList();
+        return fields;
+    };
+
+    if (!searchIndexed_) {
+        for (const auto& item : model_->getConversations())
+            searchIndex_.insert(item.uid, fields(item));
+        searchIndexed_ = true;
+        return;
+    }
+
+    // Removed conversations are no longer found.
+    for (const auto& uid : std::as_const(searchDirty_)) {
+        const auto& item = lrcInstance_->getConversationFromConvUid(uid);
+        if (item.uid.isEmpty())
+            searchIndex_.remove(uid);
+        else
+            searchIndex_.insert(uid, fields(item));
+    }
+    searchDirty_.clear();
+}
+
 ConversationListProxyModel::ConversationListProxyModel(QAbstractListModel* model, QObject* parent)
     : SelectableListProxyModel(model, parent)
 {
@@ -93,56 +309,68 @@ bool
 ConversationListProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex& sourceParent) const
 {
     QModelIndex index = sourceModel()->index(sourceRow, 0, sourceParent);
-    auto rx = filterRegularExpression();
-    auto uriStripper = URI(rx.pattern());
-    bool stripScheme = (uriStripper.schemeType() < URI::SchemeType::COUNT__);
-    FlagPack<URI::Section> flags = URI::Section::USER_INFO | URI::Section::HOSTNAME
-                                   | URI::Section::PORT;
-    if (!stripScheme) {
-        flags |= URI::Section::SCHEME;
-    }
-    rx.setPattern(uriStripper.format(flags));
 
     using namespace ConversationList;
 
-    QStringList toFilter;
-    toFilter += index.data(Role::Title).toString();
-    toFilter += index.data(Role::Uris).toStringList();
-    toFilter += index.data(Role::Monikers).toStringList();
-
     // requests
     auto isRequest = index.data(Role::IsRequest).toBool();
     bool requestFilter = filterRequests_ ? isRequest : !isRequest;
+    if (!requestFilter)
+        return false;
 
-    bool match {false};
-
-    // banned contacts require exact match
-    if (ignored_.contains(index.data(Role::UID).toString())) {
-        match = true;
-    } else if (index.data(Role::IsBanned).toBool()) {
-        if (!rx.isValid()) {
-            Q_FOREACH (const auto& filter, toFilter) {
-                auto matchResult = rx.match(filter);
-                if (matchResult.hasMatch() && matchResult.captured(0) == filter) {
-                    match = true;
-                    break;
-                }
-            }
+    auto uid = index.data(Role::UID).toString();
+    if (ignored_.contains(uid))
+        return true;
+    // banned contacts are only listed when highlighted
+    if (index.data(Role::IsBanned).toBool())
+        return false;
+
+    auto* model = qobject_cast<ConversationListModel*>(sourceModel());
+    return model && model->matchesSearch(uid, searchText());
+}
+
+QString
+ConversationListProxyModel::searchText() const
+{
+    // The filter is set as a fixed string, escaped into a pattern.
+    auto pattern = filterRegularExpression().pattern();
+    if (searchTextSet_ && pattern == filterPattern_)
+        return searchText_;
+
+    QString text;
+    text.reserve(pattern.size());
+    for (qsizetype i = 0; i < pattern.size(); ++i) {
+        if (pattern.at(i) == '\\' && i + 1 < pattern.size()) {
+            ++i;
+            // QRegularExpression::escape writes NUL as "\\0".
+            text += pattern.at(i) == '0' ? QChar(0) : pattern.at(i);
+        } else {
+            text += pattern.at(i);
         }
-    } else {
-        Q_FOREACH (const auto& filter, toFilter)
-            if (rx.match(filter).hasMatch()) {
-                match = true;
-                break;
-            }
     }
 
-    return requestFilter && match;
+    auto uriStripper = URI(text);
+    bool stripScheme = (uriStripper.schemeType() < URI::SchemeType::COUNT__);
+    FlagPack<URI::Section> flags = URI::Section::USER_INFO | URI::Section::HOSTNAME
+                                   | URI::Section::PORT;
+    if (!stripScheme) {
+        flags |= URI::Section::SCHEME;
+    }
+
+    filterPattern_ = pattern;
+    searchText_ = ConversationSearchIndex::normalize(uriStripper.format(flags));
+    searchTextSet_ = true;
+    return searchText_;
 }
 
 bool
 ConversationListProxyModel::lessThan(const QModelIndex& left, const QModelIndex& right) const
 {
+    auto* model = qobject_cast<ConversationListModel*>(sourceModel());
+    if (model && sortRole() == ConversationList::Role::LastInteractionTimeStamp)
+        return static_cast<quint64>(model->sortKey(left.row()))
+               < static_cast<quint64>(model->sortKey(right.row()));
+
     QVariant leftData = sourceModel()->data(left, sortRole());
     QVariant rightData = sourceModel()->data(right, sortRole());
     // we're assuming the sort role data type here is some integral time
@@ -157,3 +385,30 @@ ConversationListProxyModel::setFilterRequests(bool filterRequests)
     endResetModel();
     updateSelection();
 };
+
+void
+ConversationListProxyModel::setVisibleRange(int first, int last, const QSize& avatarSize)
+{
+    auto count = rowCount();
+    if (count == 0 || first < 0 || first >= count)
+        return;
+    last = last < 0 ? count - 1 : std::min(last, count - 1);
+
+    auto uid = [this](int row) {
+        return data(index(row, 0), ConversationList::Role::UID).toString();
+    };
+    QStringList visible;
+    for (int row = first; row <= last; ++row)
+        visible.append(uid(row));
+    // The rows nearest to the visible ones come first, in both directions
+    // as the scrolling direction is unknown.
+    QStringList margin;
+    auto page = last - first + 1;
+    for (int distance = 1; distance <= page; ++distance) {
+        if (last + distance < count)
+            margin.append(uid(last + distance));
+        if (first - distance >= 0)
+            margin.append(uid(first - distance));
+    }
+    Q_EMIT avatarPrefetchRequested(visible, margin, avatarSize);
+}
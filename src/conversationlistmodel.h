@@ -20,12 +20,15 @@
 #pragma once
 
 #include "conversationlistmodelbase.h"
+#include "conversationsearchindex.h"
 #include "selectablelistproxymodel.h"
 
 #include "api/profile.h"
 
 #include <QSortFilterProxyModel>
 
+#include <vector>
+
 // A wrapper view model around ConversationModel's underlying data
 class ConversationListModel final : public ConversationListModelBase
 {
@@ -36,6 +39,37 @@ public:
 
     int rowCount(const QModelIndex& parent = QModelIndex()) const override;
     QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    // Whether the title, a peer uri, alias or registered name of the
+    // conversation contains text, normalized by ConversationSearchIndex.
+    bool matchesSearch(const QString& uid, const QString& text) const;
+
+    // Timestamp of the last interaction of the row, 0 without any: the
+    // LastInteractionTimeStamp role without the QVariant.
+    qint64 sortKey(int row) const;
+
+    // Row of the conversation, -1 if it is not in the model.
+    int indexOf(const QString& uid) const;
+
+private:
+    void markSearchDirty(int first, int last);
+    void updateSearchIndex() const;
+
+    static qint64 computeSortKey(const conversation::Info& item);
+    static constexpr qint64 kUnknownSortKey {-1};
+    // Per row, computed on first use.
+    mutable std::vector<qint64> sortKeys_;
+
+    void shiftRowIndex(int position, int delta);
+    void rebuildRowIndex() const;
+    // Row of each conversation uid, kept up to date through the row
+    // insertions and removals and rebuilt when found stale.
+    mutable QHash<QString, int> rowIndex_;
+
+    // Indexed lazily, on the first search.
+    mutable ConversationSearchIndex searchIndex_;
+    mutable bool searchIndexed_ {false};
+    mutable QSet<QString> searchDirty_;
 };
 
 // The top level filtered and sorted model to be consumed by QML ListViews
@@ -53,9 +87,29 @@ public:
         ignored_ = highlighted;
     }
 
+    // Case insensitive search text of the current filter, without the
+    // uri scheme if it has one.
+    QString searchText() const;
+
+    // Called by the view as it scrolls, with the first and last visible
+    // rows (-1 for the end of the list) and the avatar pixel size.
+    Q_INVOKABLE void setVisibleRange(int first, int last, const QSize& avatarSize);
+
+Q_SIGNALS:
+    // Conversation ids whose avatars are needed now, and those of about a
+    // page of rows around them.
+    void avatarPrefetchRequested(const QStringList& visible,
+                                 const QStringList& margin,
+                                 const QSize& avatarSize);
+
 private:
     // This flag can be toggled when switching tabs to show the current account's
     // conversation invites.
     bool filterRequests_ {false};
     QStringList ignored_ {};
+
+    // Cache of searchText for filterPattern_.
+    mutable bool searchTextSet_ {false};
+    mutable QString filterPattern_;
+    mutable QString searchText_;
 };
@@ -44,82 +44,169 @@ ConversationListModelBase::roleNames() const
     return roles;
 }
 
-QVariant
-ConversationListModelBase::dataForItem(item_t item, int role) const
+quint8
+ConversationListModelBase::roleGroup(int role)
 {
     switch (role) {
-    case Role::InCall: {
-        const auto& convInfo = lrcInstance_->getConversationFromConvUid(item.uid);
-        if (!convInfo.uid.isEmpty()) {
-            auto* callModel = lrcInstance_->getCurrentCallModel();
-            return QVariant(callModel->hasCall(convInfo.callId));
-        }
-        return QVariant(false);
+    case Role::Title:
+    case Role::Uris:
+    case Role::LastInteractionTimeStamp:
+    case Role::LastInteractionDate:
+    case Role::LastInteraction:
+        return ConversationGroup;
+    case Role::Presence:
+    case Role::Monikers:
+    case Role::BestId:
+    case Role::Alias:
+    case Role::RegisteredName:
+    case Role::URI:
+    case Role::IsBanned:
+    case Role::ContactType:
+        return PeerGroup;
+    case Role::InCall:
+    case Role::IsAudioOnly:
+    case Role::CallStackViewShouldShow:
+    case Role::CallState:
+        return CallGroup;
+    case Role::Draft:
+        return DraftGroup;
+    default:
+        return NoGroup;
     }
-    case Role::IsAudioOnly: {
-        const auto& convInfo = lrcInstance_->getConversationFromConvUid(item.uid);
-        if (!convInfo.uid.isEmpty()) {
-            auto* call = lrcInstance_->getCallInfoForConversation(convInfo);
-            if (call) {
-                return QVariant(call->isAudioOnly);
-            }
+}
+
+quint8
+ConversationListModelBase::roleGroups(const QList<int>& roles)
+{
+    if (roles.isEmpty())
+        return AllGroups;
+    quint8 groups = NoGroup;
+    for (auto role : roles)
+        groups |= roleGroup(role);
+    return groups;
+}
+
+void
+ConversationListModelBase::invalidateRow(const QString& uid, quint8 groups)
+{
+    auto it = rows_.find(uid);
+    if (it == rows_.end())
+        return;
+    if (groups == AllGroups)
+        rows_.erase(it);
+    else
+        it->valid &= ~groups;
+}
+
+void
+ConversationListModelBase::clearRows()
+{
+    rows_.clear();
+}
+
+void
+ConversationListModelBase::fillRow(item_t item, RowData& row, quint8 groups) const
+{
+    if (groups & ConversationGroup) {
+        row.title = model_->title(item.uid);
+        row.uris = model_->peersForConversation(item.uid).toList();
+        row.hasLastInteraction = !item.interactions->empty();
+        if (row.hasLastInteraction) {
+            const auto& interaction = item.interactions->at(item.lastMessageUid);
+            row.lastInteractionTimeStamp = static_cast<qint32>(interaction.timestamp);
+            row.lastInteractionTime = interaction.timestamp;
+            row.lastInteraction = interaction.body;
         }
-        return QVariant(false);
     }
-    case Role::CallStackViewShouldShow: {
-        const auto& convInfo = lrcInstance_->getConversationFromConvUid(item.uid);
-        if (!convInfo.uid.isEmpty() && !convInfo.callId.isEmpty()) {
-            auto* callModel = lrcInstance_->getCurrentCallModel();
-            const auto& call = callModel->getCall(convInfo.callId);
-            return QVariant(callModel->hasCall(convInfo.callId)
-                            && ((!call.isOutgoing
-                                 && (call.status == call::Status::IN_PROGRESS
-                                     || call.status == call::Status::PAUSED
-                                     || call.status == call::Status::INCOMING_RINGING))
-                                || (call.isOutgoing && call.status != call::Status::ENDED)));
+
+    if (groups & PeerGroup) {
+        auto* contactModel = lrcInstance_->getCurrentAccountInfo().contactModel.get();
+        auto peers = model_->peersForConversation(item.uid);
+        // The conversation can show a green dot if at least one peer is present
+        row.presence = false;
+        // we shouldn't ever need these individually, they are used for filtering only
+        row.monikers.clear();
+        contact::Info contact {};
+        bool firstPeerFound {false};
+        for (int i = 0; i < peers.size(); ++i)
+            try {
+                auto peer = contactModel->getContact(peers.at(i));
+                row.presence |= peer.isPresent;
+                row.monikers << peer.profileInfo.alias << peer.registeredName;
+                if (i == 0) {
+                    contact = std::move(peer);
+                    firstPeerFound = true;
+                }
+            } catch (const std::exception&) {
+            }
+
+        row.hasContact = item.isCoreDialog() && !peers.isEmpty();
+        if (row.hasContact) {
+            auto peerUri = peers.at(0);
+            if (!firstPeerFound)
+                qWarning() << Q_FUNC_INFO << "Can't find contact" << peerUri
+                           << " this is a bug, please report";
+            row.bestId = contactModel->bestIdForContact(peerUri);
+            row.alias = contact.profileInfo.alias;
+            row.registeredName = contact.registeredName;
+            row.uri = peerUri;
+            row.isBanned = contact.isBanned;
+            row.contactType = static_cast<int>(contact.profileInfo.type);
         }
-        return QVariant(false);
     }
-    case Role::CallState: {
+
+    if (groups & CallGroup) {
+        row.inCall = false;
+        row.isAudioOnly = false;
+        row.callStackViewShouldShow = false;
+        row.callState = -1;
         const auto& convInfo = lrcInstance_->getConversationFromConvUid(item.uid);
         if (!convInfo.uid.isEmpty()) {
+            auto* callModel = lrcInstance_->getCurrentCallModel();
+            row.inCall = callModel->hasCall(convInfo.callId);
             if (auto* call = lrcInstance_->getCallInfoForConversation(convInfo)) {
-                return QVariant(static_cast<int>(call->status));
+                row.isAudioOnly = call->isAudioOnly;
+                row.callState = static_cast<int>(call->status);
+            }
+            if (!convInfo.callId.isEmpty() && row.inCall) {
+                const auto& call = callModel->getCall(convInfo.callId);
+                row.callStackViewShouldShow
+                    = (!call.isOutgoing
+                       && (call.status == call::Status::IN_PROGRESS
+                           || call.status == call::Status::PAUSED
+                           || call.status == call::Status::INCOMING_RINGING))
+                      || (call.isOutgoing && call.status != call::Status::ENDED);
             }
         }
-        return {};
     }
-    case Role::Draft: {
-        if (!item.uid.isEmpty())
-            return lrcInstance_->getContentDraft(item.uid, item.accountId);
-        return {};
+
+    if (groups & DraftGroup) {
+        row.draft = item.uid.isEmpty() ? QString()
+                                       : lrcInstance_->getContentDraft(item.uid, item.accountId);
     }
+
+    row.valid |= groups;
+}
+
+const ConversationListModelBase::RowData&
+ConversationListModelBase::cachedRow(item_t item, quint8 groups) const
+{
+    auto& row = rows_[item.uid];
+    auto missing = groups & ~row.valid;
+    if (missing)
+        fillRow(item, row, missing);
+    return row;
+}
+
+QVariant
+ConversationListModelBase::dataForItem(item_t item, int role) const
+{
+    // Roles read directly from the conversation info
+    switch (role) {
     case Role::IsRequest:
         return QVariant(item.isRequest);
-    case Role::Title:
-        return QVariant(model_->title(item.uid));
     case Role::UnreadMessagesCount:
         return QVariant(item.unreadMessages);
-    case Role::LastInteractionTimeStamp: {
-        if (!item.interactions->empty()) {
-            auto ts = static_cast<qint32>(item.interactions->at(item.lastMessageUid).timestamp);
-            return QVariant(ts);
-        }
-        break;
-    }
-    case Role::LastInteractionDate: {
-        if (!item.interactions->empty()) {
-            return QVariant(
-                Utils::formatTimeString(item.interactions->at(item.lastMessageUid).timestamp));
-        }
-        break;
-    }
-    case Role::LastInteraction: {
-        if (!item.interactions->empty()) {
-            return QVariant(item.interactions->at(item.lastMessageUid).body);
-        }
-        break;
-    }
     case Role::IsSwarm:
         return QVariant(item.isSwarm());
     case Role::IsCoreDialog:
@@ -128,68 +215,70 @@ ConversationListModelBase::dataForItem(item_t item, int role) const
         return QVariant(static_cast<int>(item.mode));
     case Role::UID:
         return QVariant(item.uid);
-    case Role::Uris:
-        return QVariant(model_->peersForConversation(item.uid).toList());
-    case Role::Monikers: {
-        // we shouldn't ever need these individually, they are used for filtering only
-        QStringList ret;
-        Q_FOREACH (const auto& peerUri, model_->peersForConversation(item.uid))
-            try {
-                auto& accInfo = lrcInstance_->getCurrentAccountInfo();
-                auto contact = accInfo.contactModel->getContact(peerUri);
-                ret << contact.profileInfo.alias << contact.registeredName;
-            } catch (const std::exception&) {
-            }
-        return ret;
-    }
     case Role::ReadOnly:
         return QVariant(item.readOnly);
-    case Role::Presence: {
-        // The conversation can show a green dot if at least one peer is present
-        Q_FOREACH (const auto& peerUri, model_->peersForConversation(item.uid))
-            try {
-                auto& accInfo = lrcInstance_->getCurrentAccountInfo();
-                auto contact = accInfo.contactModel->getContact(peerUri);
-                if (contact.isPresent)
-                    return true;
-            } catch (const std::exception&) {
-            }
-        return false;
-    };
     default:
         break;
     }
 
-    if (item.isCoreDialog()) {
-        auto peerUriList = model_->peersForConversation(item.uid);
-        if (peerUriList.isEmpty()) {
-            return {};
-        }
-        auto peerUri = peerUriList.at(0);
-        ContactModel* contactModel;
-        contact::Info contact {};
-        contactModel = lrcInstance_->getCurrentAccountInfo().contactModel.get();
-        try {
-            contact = contactModel->getContact(peerUri);
-        } catch (const std::exception&) {
-            qWarning() << Q_FUNC_INFO << "Can't find contact" << peerUri
-                       << " this is a bug, please report";
-        }
+    auto group = roleGroup(role);
+    if (group == NoGroup)
+        return {};
 
-        switch (role) {
-        case Role::BestId:
-            return QVariant(contactModel->bestIdForContact(peerUri));
-        case Role::Alias:
-            return QVariant(contact.profileInfo.alias);
-        case Role::RegisteredName:
-            return QVariant(contact.registeredName);
-        case Role::URI:
-            return QVariant(peerUri);
-        case Role::IsBanned:
-            return QVariant(contact.isBanned);
-        case Role::ContactType:
-            return QVariant(static_cast<int>(contact.profileInfo.type));
-        }
+    RowData scratch;
+    const RowData* row = &scratch;
+    if (rowCacheEnabled_)
+        row = &cachedRow(item, group);
+    else
+        fillRow(item, scratch, group);
+
+    switch (role) {
+    case Role::Title:
+        return QVariant(row->title);
+    case Role::Uris:
+        return QVariant(row->uris);
+    case Role::LastInteractionTimeStamp:
+        return row->hasLastInteraction ? QVariant(row->lastInteractionTimeStamp) : QVariant();
+    case Role::LastInteractionDate:
+        return row->hasLastInteraction
+                   ? QVariant(Utils::formatTimeString(row->lastInteractionTime))
+                   : QVariant();
+    case Role::LastInteraction:
+        return row->hasLastInteraction ? QVariant(row->lastInteraction) : QVariant();
+    case Role::Presence:
+        return QVariant(row->presence);
+    case Role::Monikers:
+        return QVariant(row->monikers);
+    case Role::InCall:
+        return QVariant(row->inCall);
+    case Role::IsAudioOnly:
+        return QVariant(row->isAudioOnly);
+    case Role::CallStackViewShouldShow:
+        return QVariant(row->callStackViewShouldShow);
+    case Role::CallState:
+        return row->callState < 0 ? QVariant() : QVariant(row->callState);
+    case Role::Draft:
+        return item.uid.isEmpty() ? QVariant() : QVariant(row->draft);
+    default:
+        break;
+    }
+
+    if (!row->hasContact)
+        return {};
+
+    switch (role) {
+    case Role::BestId:
+        return QVariant(row->bestId);
+    case Role::Alias:
+        return QVariant(row->alias);
+    case Role::RegisteredName:
+        return QVariant(row->registeredName);
+    case Role::URI:
+        return QVariant(row->uri);
+    case Role::IsBanned:
+        return QVariant(row->isBanned);
+    case Role::ContactType:
+        return QVariant(row->contactType);
     }
 
     return {};
@@ -21,6 +21,8 @@
 
 #include "abstractlistmodelbase.h"
 
+#include <ctime>
+
 // TODO: many of these roles should probably be factored out
 #define CONV_ROLES \
     X(Title) \
@@ -80,6 +82,69 @@ public:
 protected:
     using Role = ConversationList::Role;
 
+    // The roles not read directly from the conversation info, grouped by
+    // the data they are computed from.
+    enum RoleGroup : quint8 {
+        NoGroup = 0,
+        ConversationGroup = 1 << 0, // title, peers and last interaction
+        PeerGroup = 1 << 1,         // contact details and presence of the peers
+        CallGroup = 1 << 2,
+        DraftGroup = 1 << 3,
+        AllGroups = 0xf,
+    };
+    static quint8 roleGroup(int role);
+    // Groups of roles, all of them for an empty list.
+    static quint8 roleGroups(const QList<int>& roles);
+
+    // Rows are materialized on first access and kept until invalidated,
+    // which requires the model to be notified of every change of its
+    // conversations, their peers, calls and drafts.
+    bool rowCacheEnabled_ {false};
+    void invalidateRow(const QString& uid, quint8 groups = AllGroups);
+    void clearRows();
+
     // Convenience pointer to be pulled from lrcinstance
     ConversationModel* model_;
+
+private:
+    // Display roles of a conversation. Groups are filled independently,
+    // valid holding those that are up to date.
+    struct RowData
+    {
+        quint8 valid {NoGroup};
+
+        // ConversationGroup
+        QString title;
+        QStringList uris;
+        bool hasLastInteraction {false};
+        qint32 lastInteractionTimeStamp {0};
+        // Formatted when read, the date is relative to the current day.
+        std::time_t lastInteractionTime {0};
+        QString lastInteraction;
+
+        // PeerGroup, the contact fields are only set for core dialogs
+        bool presence {false};
+        QStringList monikers;
+        bool hasContact {false};
+        QString bestId;
+        QString alias;
+        QString registeredName;
+        QString uri;
+        bool isBanned {false};
+        int contactType {0};
+
+        // CallGroup
+        bool inCall {false};
+        bool isAudioOnly {false};
+        bool callStackViewShouldShow {false};
+        int callState {-1};
+
+        // DraftGroup
+        QString draft;
+    };
+
+    void fillRow(item_t item, RowData& row, quint8 groups) const;
+    const RowData& cachedRow(item_t item, quint8 groups) const;
+
+    mutable QHash<QString, RowData> rows_;
 };
@@ -72,14 +72,25 @@ ConversationsAdapter::ConversationsAdapter(SystemTray* systemTray,
             // reposition index in case of programmatic selection
             // currently, this may only occur for the conversation list
             // and not the search list
-            convModel_->selectSourceRow(lrcInstance_->indexOf(convId));
+            convModel_->selectSourceRow(convSrcModel_->indexOf(convId));
         }
     });
 
+    // the counts of a removed account are dropped along with it
+    connect(&lrcInstance_->accountModel(),
+            &NewAccountModel::accountRemoved,
+            this,
+            [this](const QString& accountId) {
+                invalidateCounts(accountId);
+                updateConversationFilterData();
+            });
+
     connect(lrcInstance_, &LRCInstance::draftSaved, [this](const QString& convId) {
-        auto row = lrcInstance_->indexOf(convId);
+        auto row = convSrcModel_->indexOf(convId);
+        if (row < 0)
+            return;
         const auto index = convSrcModel_->index(row, 0);
-        Q_EMIT convSrcModel_->dataChanged(index, index);
+        Q_EMIT convSrcModel_->dataChanged(index, index, {ConversationList::Role::Draft});
     });
 
 #ifdef Q_OS_LINUX
@@ -169,16 +180,15 @@ ConversationsAdapter::onNewUnreadInteraction(const QString& accountId,
         auto& accountInfo = lrcInstance_->getAccountInfo(accountId);
         auto from = accountInfo.contactModel->bestNameForContact(interaction.authorUri);
 #ifdef Q_OS_LINUX
-        auto contactPhoto = Utils::contactPhoto(lrcInstance_,
-                                                interaction.authorUri,
-                                                QSize(50, 50),
-                                                accountId);
+        auto contactPhoto = Utils::notificationAvatar(lrcInstance_,
+                                                      interaction.authorUri,
+                                                      accountId);
         auto notifId = QString("%1;%2;%3").arg(accountId).arg(convUid).arg(interactionId);
         systemTray_->showNotification(notifId,
                                       tr("New message"),
                                       from + ": " + interaction.body,
                                       NotificationType::CHAT,
-                                      Utils::QImageToByteArray(contactPhoto));
+                                      contactPhoto);
 
 #else
         Q_UNUSED(interactionId)
@@ -191,8 +201,9 @@ ConversationsAdapter::onNewUnreadInteraction(const QString& accountId,
         };
         systemTray_->showNotification(interaction.body, from, onClicked);
 #endif
-        updateConversationFilterData();
     }
+    updateCounts(accountId, convUid);
+    updateConversationFilterData();
 }
 
 void
@@ -205,10 +216,10 @@ ConversationsAdapter::onNewReadInteraction(const QString& accountId,
     auto notifId = QString("%1;%2;%3").arg(accountId).arg(convUid).arg(interactionId);
     systemTray_->hideNotification(notifId);
 #else
-    Q_UNUSED(accountId)
-    Q_UNUSED(convUid)
     Q_UNUSED(interactionId)
 #endif
+    updateCounts(accountId, convUid);
+    updateConversationFilterData();
 }
 
 void
@@ -226,18 +237,22 @@ ConversationsAdapter::onNewTrustRequest(const QString& accountId,
         }
         auto& accInfo = lrcInstance_->getAccountInfo(accountId);
         auto from = accInfo.contactModel->bestNameForContact(peerUri);
-        auto contactPhoto = Utils::contactPhoto(lrcInstance_, peerUri, QSize(50, 50), accountId);
+        auto contactPhoto = Utils::notificationAvatar(lrcInstance_, peerUri, accountId);
         auto notifId = QString("%1;%2").arg(accountId).arg(conv);
         systemTray_->showNotification(notifId,
                                       tr("Trust request"),
                                       "New request from " + from,
                                       NotificationType::REQUEST,
-                                      Utils::QImageToByteArray(contactPhoto));
+                                      contactPhoto);
     }
 #else
-    Q_UNUSED(accountId)
     Q_UNUSED(peerUri)
 #endif
+    // Without a conversation id, the request is only found by its peer.
+    if (!convId.isEmpty())
+        updateCounts(accountId, convId);
+    else
+        invalidateCounts(accountId);
     updateConversationFilterData();
 }
 
@@ -249,14 +264,17 @@ ConversationsAdapter::onTrustRequestTreated(const QString& accountId, const QStr
     auto notifId = QString("%1;%2").arg(accountId).arg(peerUri);
     systemTray_->hideNotification(notifId);
 #else
-    Q_UNUSED(accountId)
     Q_UNUSED(peerUri)
 #endif
+    // A declined request is removed along with its conversation.
+    invalidateCounts(accountId);
+    updateConversationFilterData();
 }
 
 void
 ConversationsAdapter::onModelChanged()
 {
+    invalidateCounts(senderAccountId());
     updateConversationFilterData();
 }
 
@@ -268,7 +286,9 @@ ConversationsAdapter::onProfileUpdated(const QString& contactUri)
         return;
 
     // notify UI elements
-    auto row = lrcInstance_->indexOf(convInfo.uid);
+    auto row = convSrcModel_->indexOf(convInfo.uid);
+    if (row < 0)
+        return;
     const auto index = convSrcModel_->index(row, 0);
     Q_EMIT convSrcModel_->dataChanged(index, index);
 }
@@ -276,6 +296,7 @@ ConversationsAdapter::onProfileUpdated(const QString& contactUri)
 void
 ConversationsAdapter::onConversationUpdated(const QString& convId)
 {
+    updateCounts(senderAccountId(), convId);
     updateConversationFilterData();
 }
 
@@ -336,9 +357,13 @@ ConversationsAdapter::onBannedStatusChanged(const QString& uri, bool banned)
     auto& convInfo = lrcInstance_->getConversationFromPeerUri(uri);
     if (convInfo.uid.isEmpty())
         return;
-    auto row = lrcInstance_->indexOf(convInfo.uid);
-    const auto index = convSrcModel_->index(row, 0);
-    Q_EMIT convSrcModel_->dataChanged(index, index);
+    auto row = convSrcModel_->indexOf(convInfo.uid);
+    if (row >= 0) {
+        const auto index = convSrcModel_->index(row, 0);
+        Q_EMIT convSrcModel_->dataChanged(index, index);
+    }
+    updateCounts(convInfo.accountId, convInfo.uid);
+    updateConversationFilterData();
     lrcInstance_->set_selectedConvUid();
 }
 
@@ -356,26 +381,141 @@ ConversationsAdapter::updateConversation(const QString& convId)
 void
 ConversationsAdapter::updateConversationFilterData()
 {
-    // TODO: this may be further spliced to respond separately to
-    // incoming messages and invites
     // total unread message and pending invite counts, and tab selection
-    auto& accountInfo = lrcInstance_->getCurrentAccountInfo();
-    int totalUnreadMessages {0};
-    if (accountInfo.profileInfo.type != profile::Type::SIP) {
-        auto& convModel = accountInfo.conversationModel;
-        auto conversations = convModel->getFilteredConversations(FilterType::JAMI, false);
-        conversations.for_each([&totalUnreadMessages](const conversation::Info& conversation) {
-            totalUnreadMessages += conversation.unreadMessages;
-        });
-    }
-    set_totalUnreadMessageCount(totalUnreadMessages);
-    set_pendingRequestCount(accountInfo.conversationModel->pendingRequestCount());
-    systemTray_->setCount(lrcInstance_->notificationsCount());
+    const auto& counts = accountCounts(lrcInstance_->get_currentAccountId());
+    set_totalUnreadMessageCount(counts.unread);
+    set_pendingRequestCount(counts.pendingRequests);
+
+    int notifications {0};
+    for (const auto& accountId : lrcInstance_->accountModel().getAccountList())
+        notifications += accountCounts(accountId).notifications;
+    systemTray_->setCount(notifications);
 
     if (get_pendingRequestCount() == 0 && get_filterRequests())
         set_filterRequests(false);
 }
 
+ConversationsAdapter::ConversationCounts
+ConversationsAdapter::countConversation(const account::Info& accInfo,
+                                        const conversation::Info& convInfo) const
+{
+    ConversationCounts counts;
+    counts.isRequest = convInfo.isRequest;
+    counts.notifications = convInfo.isRequest ? 1 : convInfo.unreadMessages;
+    if (convInfo.isRequest || accInfo.profileInfo.type == profile::Type::SIP)
+        return counts;
+
+    // Like the JAMI conversation filter, leave out the conversations
+    // whose first peer is banned or unknown.
+    auto peer = std::find_if(convInfo.participants.cbegin(),
+                             convInfo.participants.cend(),
+                             [&accInfo](const auto& member) {
+                                 return member.uri != accInfo.profileInfo.uri;
+                             });
+    if (peer == convInfo.participants.cend())
+        return counts;
+    try {
+        if (accInfo.contactModel->getContact(peer->uri).isBanned)
+            return counts;
+    } catch (...) {
+        return counts;
+    }
+    counts.unread = convInfo.unreadMessages;
+    return counts;
+}
+
+const conversation::Info&
+ConversationsAdapter::findConversation(const QString& convUid, const QString& accountId)
+{
+    // The row index of the list model avoids a scan of the conversations
+    // of the current account.
+    if (accountId == lrcInstance_->get_currentAccountId()) {
+        const auto& data = lrcInstance_->getCurrentConversationModel()->getConversations();
+        auto row = convSrcModel_->indexOf(convUid);
+        if (row >= 0 && row < data.size() && data.at(row).uid == convUid)
+            return data.at(row);
+    }
+    return lrcInstance_->getConversationFromConvUid(convUid, accountId);
+}
+
+ConversationsAdapter::AccountCounts&
+ConversationsAdapter::accountCounts(const QString& accountId)
+{
+    auto it = counts_.find(accountId);
+    if (it != counts_.end())
+        return *it;
+
+    auto& counts = counts_[accountId];
+    try {
+        auto& accInfo = lrcInstance_->getAccountInfo(accountId);
+        // The counts of background accounts are kept up to date as well.
+        auto convModel = accInfo.conversationModel.get();
+        QObject::connect(convModel,
+                         &ConversationModel::modelChanged,
+                         this,
+                         &ConversationsAdapter::onModelChanged,
+                         Qt::UniqueConnection);
+        QObject::connect(convModel,
+                         &ConversationModel::conversationUpdated,
+                         this,
+                         &ConversationsAdapter::onConversationUpdated,
+                         Qt::UniqueConnection);
+        for (const auto& convInfo : accInfo.conversationModel->getConversations()) {
+            auto convCounts = countConversation(accInfo, convInfo);
+            counts.unread += convCounts.unread;
+            counts.notifications += convCounts.notifications;
+            counts.pendingRequests += convCounts.isRequest;
+            counts.conversations.insert(convInfo.uid, convCounts);
+        }
+    } catch (...) {
+        qWarning() << Q_FUNC_INFO << "Can't count the conversations of" << accountId;
+    }
+    return counts;
+}
+
+void
+ConversationsAdapter::updateCounts(const QString& accountId, const QString& convUid)
+{
+    // Not counted yet, it will be from scratch on first use.
+    auto it = counts_.find(accountId);
+    if (it == counts_.end())
+        return;
+
+    try {
+        auto& accInfo = lrcInstance_->getAccountInfo(accountId);
+        const auto& convInfo = findConversation(convUid, accountId);
+        auto& counts = *it;
+        auto previous = counts.conversations.take(convUid);
+        counts.unread -= previous.unread;
+        counts.notifications -= previous.notifications;
+        counts.pendingRequests -= previous.isRequest;
+        if (convInfo.uid.isEmpty())
+            return;
+
+        auto current = countConversation(accInfo, convInfo);
+        counts.unread += current.unread;
+        counts.notifications += current.notifications;
+        counts.pendingRequests += current.isRequest;
+        counts.conversations.insert(convUid, current);
+    } catch (...) {
+        invalidateCounts(accountId);
+    }
+}
+
+void
+ConversationsAdapter::invalidateCounts(const QString& accountId)
+{
+    counts_.remove(accountId);
+}
+
+QString
+ConversationsAdapter::senderAccountId() const
+{
+    if (auto* model = qobject_cast<ConversationModel*>(sender()))
+        return model->owner.id;
+    return lrcInstance_->get_currentAccountId();
+}
+
 void
 ConversationsAdapter::setFilter(const QString& filterString)
 {
@@ -61,6 +61,11 @@ public:
                                                    const QString& newDescription);
 
     Q_INVOKABLE QString dialogId(const QString& peerUri);
+
+    ConversationListProxyModel* conversationListModel() const
+    {
+        return convModel_.get();
+    }
     Q_INVOKABLE void openDialogConversationWith(const QString& peerUri);
 Q_SIGNALS:
     void showConversation(const QString& accountId, const QString& convUid);
@@ -84,10 +89,12 @@ private Q_SLOTS:
     void onNewTrustRequest(const QString& accountId, const QString& convId, const QString& peerUri);
     void onTrustRequestTreated(const QString& accountId, const QString& peerUri);
 
-    // per-account slots
+    // connected for every account, keeping its counts up to date
     void onModelChanged();
-    void onProfileUpdated(const QString&);
     void onConversationUpdated(const QString&);
+
+    // per-account slots
+    void onProfileUpdated(const QString&);
     void onFilterChanged();
     void onConversationCleared(const QString&);
     void onSearchStatusChanged(const QString&);
@@ -99,10 +106,41 @@ private:
     void updateConversation(const QString&);
     void updateConversationFilterData();
 
+    // Unread message and pending request counts of the conversations of
+    // an account, kept per conversation so that an event only recounts
+    // the conversation it is about.
+    struct ConversationCounts
+    {
+        // Counted in totalUnreadMessageCount: not a request nor banned.
+        int unread {0};
+        // Counted in the system tray: unread messages, 1 for a request.
+        int notifications {0};
+        bool isRequest {false};
+    };
+    struct AccountCounts
+    {
+        QHash<QString, ConversationCounts> conversations;
+        int unread {0};
+        int notifications {0};
+        int pendingRequests {0};
+    };
+    ConversationCounts countConversation(const account::Info& accInfo,
+                                         const conversation::Info& convInfo) const;
+    const conversation::Info& findConversation(const QString& convUid,
+                                               const QString& accountId);
+    AccountCounts& accountCounts(const QString& accountId);
+    void updateCounts(const QString& accountId, const QString& convUid);
+    void invalidateCounts(const QString& accountId);
+    // Account of the ConversationModel sending the current signal.
+    QString senderAccountId() const;
+
     SystemTray* systemTray_;
 
     QScopedPointer<ConversationListModel> convSrcModel_;
     QScopedPointer<ConversationListProxyModel> convModel_;
     QScopedPointer<SearchResultsListModel> searchSrcModel_;
     QScopedPointer<SelectableListProxyModel> searchModel_;
+
+    // Counted on first use, per account id.
+    QHash<QString, AccountCounts> counts_;
 };
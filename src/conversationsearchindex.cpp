@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2022 Savoir-faire Linux Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "conversationsearchindex.h"
+
+#include <algorithm>
+
+QString
+ConversationSearchIndex::normalize(const QString& text)
+{
+    return text.toCaseFolded();
+}
+
+std::vector<ConversationSearchIndex::Trigram>
+ConversationSearchIndex::trigrams(const QString& text)
+{
+    std::vector<Trigram> result;
+    const auto* data = text.utf16();
+    for (qsizetype i = 0; i + 3 <= text.size(); ++i) {
+        // Trigrams spanning two fields are never searched for.
+        if (!data[i] || !data[i + 1] || !data[i + 2])
+            continue;
+        result.push_back((Trigram(data[i]) << 32) | (Trigram(data[i + 1]) << 16) | data[i + 2]);
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+void
+ConversationSearchIndex::addPostings(int slot)
+{
+    for (auto trigram : trigrams(texts_[slot]))
+        postings_[trigram].push_back(slot);
+}
+
+void
+ConversationSearchIndex::removePostings(int slot)
+{
+    for (auto trigram : trigrams(texts_[slot])) {
+        auto it = postings_.find(trigram);
+        if (it == postings_.end())
+            continue;
+        auto& posting = it.value();
+        auto pos = std::find(posting.begin(), posting.end(), slot);
+        if (pos != posting.end()) {
+            *pos = posting.back();
+            posting.pop_back();
+        }
+        if (posting.empty())
+            postings_.erase(it);
+    }
+}
+
+void
+ConversationSearchIndex::insert(const QString& id, const QStringList& fields)
+{
+    auto text = normalize(fields.join(QChar(0)));
+
+    int slot;
+    auto it = slots_.constFind(id);
+    if (it != slots_.cend()) {
+        slot = it.value();
+        if (texts_[slot] == text)
+            return;
+        removePostings(slot);
+    } else if (!freeSlots_.empty()) {
+        slot = freeSlots_.back();
+        freeSlots_.pop_back();
+        slots_.insert(id, slot);
+    } else {
+        slot = static_cast<int>(ids_.size());
+        ids_.emplace_back();
+        texts_.emplace_back();
+        matches_.push_back(0);
+        slots_.insert(id, slot);
+    }
+    ids_[slot] = id;
+    texts_[slot] = std::move(text);
+    addPostings(slot);
+
+    // Keep the last search result up to date.
+    matches_[slot] = searched_ && texts_[slot].contains(needle_);
+}
+
+void
+ConversationSearchIndex::remove(const QString& id)
+{
+    auto it = slots_.find(id);
+    if (it == slots_.end())
+        return;
+    auto slot = it.value();
+    slots_.erase(it);
+    removePostings(slot);
+    ids_[slot].clear();
+    texts_[slot].clear();
+    matches_[slot] = 0;
+    freeSlots_.push_back(slot);
+}
+
+void
+ConversationSearchIndex::clear()
+{
+    slots_.clear();
+    ids_.clear();
+    texts_.clear();
+    freeSlots_.clear();
+    postings_.clear();
+    matches_.clear();
+    searched_ = false;
+    needle_.clear();
+}
+
+bool
+ConversationSearchIndex::contains(const QString& id) const
+{
+    return slots_.contains(id);
+}
+
+qsizetype
+ConversationSearchIndex::size() const
+{
+    return slots_.size();
+}
+
+void
+ConversationSearchIndex::search(const QString& needle)
+{
+    auto verify = [&](int slot) {
+        return !ids_[slot].isEmpty() && texts_[slot].contains(needle);
+    };
+
+    if (searched_ && needle.contains(needle_)) {
+        // The text was extended, only the previous matches can match.
+        for (size_t slot = 0; slot < matches_.size(); ++slot)
+            matches_[slot] = matches_[slot] && verify(static_cast<int>(slot));
+    } else if (needle.size() >= 3) {
+        // Only the items having every trigram of the text can match,
+        // verify those having the rarest one.
+        std::fill(matches_.begin(), matches_.end(), 0);
+        const std::vector<int>* rarest = nullptr;
+        for (auto trigram : trigrams(needle)) {
+            auto it = postings_.constFind(trigram);
+            if (it == postings_.cend()) {
+                rarest = nullptr;
+                break;
+            }
+            if (!rarest || it->size() < rarest->size())
+                rarest = &it.value();
+        }
+        if (rarest) {
+            for (auto slot : *rarest)
+                matches_[slot] = verify(slot);
+        }
+    } else {
+        for (size_t slot = 0; slot < matches_.size(); ++slot)
+            matches_[slot] = verify(static_cast<int>(slot));
+    }
+
+    searched_ = true;
+    needle_ = needle;
+}
+
+bool
+ConversationSearchIndex::matches(const QString& id, const QString& needle)
+{
+    if (!searched_ || needle != needle_)
+        search(needle);
+    auto it = slots_.constFind(id);
+    return it != slots_.cend() && matches_[it.value()];
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2022 Savoir-faire Linux Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+#include <vector>
+
+// Substring search over the text fields of a set of items (the titles,
+// peer uris, aliases and registered names of conversations). Fields are
+// case folded once when an item is inserted, and indexed by trigram so
+// that a search only verifies the items sharing the rarest trigram of
+// the searched text. The result of the last search is kept and patched
+// by insertions and removals, and narrowed when the text is extended.
+class ConversationSearchIndex
+{
+public:
+    // The form fields and searched texts are compared in.
+    static QString normalize(const QString& text);
+
+    // Adds the item or replaces its fields.
+    void insert(const QString& id, const QStringList& fields);
+    void remove(const QString& id);
+    void clear();
+    bool contains(const QString& id) const;
+    qsizetype size() const;
+
+    // Whether a field of the item contains needle, a normalized text.
+    bool matches(const QString& id, const QString& needle);
+
+private:
+    using Trigram = quint64;
+    static std::vector<Trigram> trigrams(const QString& text);
+
+    void search(const QString& needle);
+    void addPostings(int slot);
+    void removePostings(int slot);
+
+    QHash<QString, int> slots_;
+    // Per slot, reused once freed.
+    std::vector<QString> ids_;
+    // Fields of the item, separated by '\0' so that no match spans two.
+    std::vector<QString> texts_;
+    std::vector<int> freeSlots_;
+    QHash<Trigram, std::vector<int>> postings_;
+
+    bool searched_ {false};
+    QString needle_;
+    std::vector<char> matches_;
+};
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2022 Savoir-faire Linux Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "imagecache.h"
+
+ImageCache::ImageCache(qsizetype maxBytes)
+    : cache_(maxBytes)
+{}
+
+QImage
+ImageCache::find(const QString& key)
+{
+    QMutexLocker lk(&mutex_);
+    // QCache::object moves the entry to the front of the LRU list.
+    if (auto image = cache_.object(key)) {
+        ++hits_;
+        return *image;
+    }
+    ++misses_;
+    return {};
+}
+
+bool
+ImageCache::contains(const QString& key) const
+{
+    QMutexLocker lk(&mutex_);
+    return cache_.contains(key);
+}
+
+void
+ImageCache::insert(const QString& key, const QImage& image)
+{
+    if (image.isNull()) {
+        return;
+    }
+    QMutexLocker lk(&mutex_);
+    // Images larger than the budget are simply not cached.
+    cache_.insert(key, new QImage(image), image.sizeInBytes());
+}
+
+void
+ImageCache::remove(const QString& key)
+{
+    QMutexLocker lk(&mutex_);
+    cache_.remove(key);
+}
+
+void
+ImageCache::clear()
+{
+    QMutexLocker lk(&mutex_);
+    cache_.clear();
+}
+
+void
+ImageCache::setMaxBytes(qsizetype maxBytes)
+{
+    QMutexLocker lk(&mutex_);
+    cache_.setMaxCost(maxBytes);
+}
+
+QVariantMap
+ImageCache::stats() const
+{
+    QMutexLocker lk(&mutex_);
+    return {{"bytes", static_cast<qint64>(cache_.totalCost())},
+            {"maxBytes", static_cast<qint64>(cache_.maxCost())},
+            {"count", static_cast<int>(cache_.count())},
+            {"hits", QVariant::fromValue(hits_.load())},
+            {"misses", QVariant::fromValue(misses_.load())}};
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2022 Savoir-faire Linux Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QVariantMap>
+
+#include <atomic>
+
+// Thread-safe LRU cache of final images, bounded by the byte size of the
+// cached images. Images are implicitly shared, a hit does not copy pixels.
+class ImageCache
+{
+public:
+    explicit ImageCache(qsizetype maxBytes = 64 * 1024 * 1024);
+
+    // Returns a null image on a miss.
+    QImage find(const QString& key);
+    // Does not count as a hit or miss, nor refresh the entry.
+    bool contains(const QString& key) const;
+    void insert(const QString& key, const QImage& image);
+    void remove(const QString& key);
+    void clear();
+
+    void setMaxBytes(qsizetype maxBytes);
+
+    // Cached bytes, byte budget, entry count, hits and misses.
+    QVariantMap stats() const;
+
+private:
+    mutable QMutex mutex_;
+    QCache<QString, QImage> cache_;
+    std::atomic<quint64> hits_ {0};
+    std::atomic<quint64> misses_ {0};
+};
@@ -0,0 +1,348 @@
+/*
+ * Copyright (C) 2022 Savoir-faire Linux Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "imagekernels.h"
+
+#include "imagecache.h"
+
+#include <QPainter>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define IMAGEKERNELS_SSE2
+#endif
+// The AVX2 kernels are built for their own target and dispatched at
+// runtime, the rest of the file keeps the baseline instruction set.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define IMAGEKERNELS_AVX2
+#define IMAGEKERNELS_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+namespace {
+
+// Per channel x * a / 255, rounded like QPainter's BYTE_MUL.
+inline quint32
+byteMul(quint32 x, quint32 a)
+{
+    quint32 t = (x & 0xff00ff) * a;
+    t = (t + ((t >> 8) & 0xff00ff) + 0x800080) >> 8;
+    t &= 0xff00ff;
+    x = ((x >> 8) & 0xff00ff) * a;
+    x = (x + ((x >> 8) & 0xff00ff) + 0x800080);
+    x &= 0xff00ff00;
+    return x | t;
+}
+
+inline quint32
+splitPixel(quint32 left, uchar leftMask, quint32 right, uchar rightMask)
+{
+    auto l = byteMul(left, leftMask);
+    auto r = byteMul(right, rightMask);
+    // SourceOver, byteMul(l, 255) == l when r is transparent.
+    return r + byteMul(l, 255 - (r >> 24));
+}
+
+#ifdef IMAGEKERNELS_SSE2
+// 16-bit lanes x * a / 255, rounded like byteMul.
+inline __m128i
+byteMul16(__m128i x, __m128i a)
+{
+    __m128i t = _mm_mullo_epi16(x, a);
+    t = _mm_add_epi16(t, _mm_srli_epi16(t, 8));
+    t = _mm_add_epi16(t, _mm_set1_epi16(0x80));
+    return _mm_srli_epi16(t, 8);
+}
+
+// The coverage of 4 pixels spread over their channels, as 16-bit lanes
+// for the low and high pixel pairs.
+inline void
+spreadMask(const uchar* mask, __m128i& lo, __m128i& hi)
+{
+    quint32 bytes;
+    memcpy(&bytes, mask, sizeof(bytes));
+    __m128i m = _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(bytes)),
+                                  _mm_setzero_si128());
+    m = _mm_unpacklo_epi16(m, m);
+    lo = _mm_unpacklo_epi32(m, m);
+    hi = _mm_unpackhi_epi32(m, m);
+}
+
+inline __m128i
+inverseAlpha16(__m128i x)
+{
+    __m128i a = _mm_shufflelo_epi16(x, _MM_SHUFFLE(3, 3, 3, 3));
+    a = _mm_shufflehi_epi16(a, _MM_SHUFFLE(3, 3, 3, 3));
+    return _mm_sub_epi16(_mm_set1_epi16(0xff), a);
+}
+#endif
+
+#ifdef IMAGEKERNELS_AVX2
+IMAGEKERNELS_AVX2_TARGET inline __m256i
+byteMul16(__m256i x, __m256i a)
+{
+    __m256i t = _mm256_mullo_epi16(x, a);
+    t = _mm256_add_epi16(t, _mm256_srli_epi16(t, 8));
+    t = _mm256_add_epi16(t, _mm256_set1_epi16(0x80));
+    return _mm256_srli_epi16(t, 8);
+}
+
+// As above for 8 pixels: the unpacks work within 128-bit lanes, so the
+// low lane holds pixels 0-3 and the high lane pixels 4-7.
+IMAGEKERNELS_AVX2_TARGET inline void
+spreadMask(const uchar* mask, __m256i& lo, __m256i& hi)
+{
+    __m128i m = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(mask)),
+                                  _mm_setzero_si128());
+    __m256i m2 = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi16(m, m)),
+                                         _mm_unpackhi_epi16(m, m),
+                                         1);
+    lo = _mm256_unpacklo_epi32(m2, m2);
+    hi = _mm256_unpackhi_epi32(m2, m2);
+}
+
+IMAGEKERNELS_AVX2_TARGET inline __m256i
+inverseAlpha16(__m256i x)
+{
+    __m256i a = _mm256_shufflelo_epi16(x, _MM_SHUFFLE(3, 3, 3, 3));
+    a = _mm256_shufflehi_epi16(a, _MM_SHUFFLE(3, 3, 3, 3));
+    return _mm256_sub_epi16(_mm256_set1_epi16(0xff), a);
+}
+
+// The AVX2 parts of maskRow and splitRow, returning the number of
+// pixels processed.
+IMAGEKERNELS_AVX2_TARGET int
+maskRowAvx2(quint32* dst, const quint32* src, const uchar* mask, int count)
+{
+    int i = 0;
+    const __m256i zero = _mm256_setzero_si256();
+    for (; i + 8 <= count; i += 8) {
+        __m256i px = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i mLo, mHi;
+        spreadMask(mask + i, mLo, mHi);
+        __m256i lo = byteMul16(_mm256_unpacklo_epi8(px, zero), mLo);
+        __m256i hi = byteMul16(_mm256_unpackhi_epi8(px, zero), mHi);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_packus_epi16(lo, hi));
+    }
+    return i;
+}
+
+IMAGEKERNELS_AVX2_TARGET int
+splitRowAvx2(quint32* dst,
+             const quint32* left,
+             const uchar* leftMask,
+             const quint32* right,
+             const uchar* rightMask,
+             int count)
+{
+    int i = 0;
+    const __m256i zero = _mm256_setzero_si256();
+    for (; i + 8 <= count; i += 8) {
+        __m256i l = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(left + i));
+        __m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(right + i));
+        __m256i lmLo, lmHi, rmLo, rmHi;
+        spreadMask(leftMask + i, lmLo, lmHi);
+        spreadMask(rightMask + i, rmLo, rmHi);
+        __m256i lLo = byteMul16(_mm256_unpacklo_epi8(l, zero), lmLo);
+        __m256i lHi = byteMul16(_mm256_unpackhi_epi8(l, zero), lmHi);
+        __m256i rLo = byteMul16(_mm256_unpacklo_epi8(r, zero), rmLo);
+        __m256i rHi = byteMul16(_mm256_unpackhi_epi8(r, zero), rmHi);
+        __m256i lo = _mm256_add_epi16(rLo, byteMul16(lLo, inverseAlpha16(rLo)));
+        __m256i hi = _mm256_add_epi16(rHi, byteMul16(lHi, inverseAlpha16(rHi)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_packus_epi16(lo, hi));
+    }
+    return i;
+}
+
+inline bool
+hasAvx2()
+{
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+#endif
+
+// Masks are small and shared by every avatar of the same size.
+ImageCache&
+maskCache()
+{
+    static ImageCache cache(2 * 1024 * 1024);
+    return cache;
+}
+
+QImage
+rasterizeMask(const QSize& size, const std::function<void(QPainter&)>& draw)
+{
+    QImage target(size, QImage::Format_ARGB32_Premultiplied);
+    target.fill(Qt::transparent);
+    QPainter painter(&target);
+    painter.setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform);
+    painter.setBrush(QBrush(Qt::white));
+    draw(painter);
+    painter.end();
+    return target.convertToFormat(QImage::Format_Alpha8);
+}
+
+} // namespace
+
+void
+ImageKernels::maskRow(quint32* dst, const quint32* src, const uchar* mask, int count)
+{
+    int i = 0;
+#ifdef IMAGEKERNELS_AVX2
+    if (hasAvx2())
+        i = maskRowAvx2(dst, src, mask, count);
+#endif
+#ifdef IMAGEKERNELS_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 4 <= count; i += 4) {
+        __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i mLo, mHi;
+        spreadMask(mask + i, mLo, mHi);
+        __m128i lo = byteMul16(_mm_unpacklo_epi8(px, zero), mLo);
+        __m128i hi = byteMul16(_mm_unpackhi_epi8(px, zero), mHi);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; i < count; ++i)
+        dst[i] = byteMul(src[i], mask[i]);
+}
+
+void
+ImageKernels::splitRow(quint32* dst,
+                       const quint32* left,
+                       const uchar* leftMask,
+                       const quint32* right,
+                       const uchar* rightMask,
+                       int count)
+{
+    int i = 0;
+#ifdef IMAGEKERNELS_AVX2
+    if (hasAvx2())
+        i = splitRowAvx2(dst, left, leftMask, right, rightMask, count);
+#endif
+#ifdef IMAGEKERNELS_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 4 <= count; i += 4) {
+        __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(left + i));
+        __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(right + i));
+        __m128i lmLo, lmHi, rmLo, rmHi;
+        spreadMask(leftMask + i, lmLo, lmHi);
+        spreadMask(rightMask + i, rmLo, rmHi);
+        __m128i lLo = byteMul16(_mm_unpacklo_epi8(l, zero), lmLo);
+        __m128i lHi = byteMul16(_mm_unpackhi_epi8(l, zero), lmHi);
+        __m128i rLo = byteMul16(_mm_unpacklo_epi8(r, zero), rmLo);
+        __m128i rHi = byteMul16(_mm_unpackhi_epi8(r, zero), rmHi);
+        __m128i lo = _mm_add_epi16(rLo, byteMul16(lLo, inverseAlpha16(rLo)));
+        __m128i hi = _mm_add_epi16(rHi, byteMul16(lHi, inverseAlpha16(rHi)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; i < count; ++i)
+        dst[i] = splitPixel(left[i], leftMask[i], right[i], rightMask[i]);
+}
+
+QImage
+ImageKernels::circleMask(int size)
+{
+    auto key = QString("circle_%1").arg(size);
+    auto mask = maskCache().find(key);
+    if (mask.isNull()) {
+        mask = rasterizeMask(QSize(size, size),
+                             [size](QPainter& painter) { painter.drawEllipse(0, 0, size, size); });
+        maskCache().insert(key, mask);
+    }
+    return mask;
+}
+
+QImage
+ImageKernels::halfMask(const QSize& size, bool leftSide)
+{
+    auto key = QString("half_%1x%2_%3").arg(size.width()).arg(size.height()).arg(leftSide);
+    auto mask = maskCache().find(key);
+    if (mask.isNull()) {
+        mask = rasterizeMask(size, [size, leftSide](QPainter& painter) {
+            auto width = size.width();
+            painter.drawRect(leftSide ? 0 : width / 2 + 2,
+                             0,
+                             width / 2 - (leftSide ? 2 : 0),
+                             size.height());
+        });
+        maskCache().insert(key, mask);
+    }
+    return mask;
+}
+
+QImage
+ImageKernels::circleCrop(const QImage& photo, int size, int xOffset)
+{
+    QImage target(size, size, QImage::Format_ARGB32_Premultiplied);
+    target.fill(Qt::transparent);
+    auto src = photo.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    auto mask = circleMask(size);
+    // Only the part of the photo covering the circle is drawn.
+    auto rows = std::min(size, src.height());
+    auto columns = std::clamp(src.width() - xOffset, 0, size);
+    for (int y = 0; y < rows; ++y) {
+        maskRow(reinterpret_cast<quint32*>(target.scanLine(y)),
+                reinterpret_cast<const quint32*>(src.constScanLine(y)) + xOffset,
+                mask.constScanLine(y),
+                columns);
+    }
+    return target;
+}
+
+QImage
+ImageKernels::halfCrop(const QImage& image, bool leftSide)
+{
+    auto src = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    QImage target(src.size(), QImage::Format_ARGB32_Premultiplied);
+    auto mask = halfMask(src.size(), leftSide);
+    for (int y = 0; y < src.height(); ++y) {
+        maskRow(reinterpret_cast<quint32*>(target.scanLine(y)),
+                reinterpret_cast<const quint32*>(src.constScanLine(y)),
+                mask.constScanLine(y),
+                src.width());
+    }
+    return target;
+}
+
+QImage
+ImageKernels::splitCrop(const QImage& left, const QImage& right)
+{
+    if (left.size() != right.size()) {
+        return {};
+    }
+    auto leftSrc = left.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    auto rightSrc = right.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    QImage target(left.size(), QImage::Format_ARGB32_Premultiplied);
+    auto leftMask = halfMask(left.size(), true);
+    auto rightMask = halfMask(left.size(), false);
+    for (int y = 0; y < target.height(); ++y) {
+        splitRow(reinterpret_cast<quint32*>(target.scanLine(y)),
+                 reinterpret_cast<const quint32*>(leftSrc.constScanLine(y)),
+                 leftMask.constScanLine(y),
+                 reinterpret_cast<const quint32*>(rightSrc.constScanLine(y)),
+                 rightMask.constScanLine(y),
+                 target.width());
+    }
+    return target;
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2022 Savoir-faire Linux Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QImage>
+
+// Avatar compositing kernels, producing the same pixels as the QPainter
+// SourceIn/SourceOver compositions they replace, in a single pass over
+// premultiplied ARGB32 rows. The antialiased masks are rasterized once
+// per size by QPainter and cached.
+namespace ImageKernels {
+
+// dst[i] = src[i] * mask[i] / 255: src composed SourceIn onto a mask of
+// coverage mask[i].
+void maskRow(quint32* dst, const quint32* src, const uchar* mask, int count);
+
+// dst[i] = (right[i] * rightMask[i] / 255) over (left[i] * leftMask[i] / 255).
+void splitRow(quint32* dst,
+              const quint32* left,
+              const uchar* leftMask,
+              const quint32* right,
+              const uchar* rightMask,
+              int count);
+
+// Coverage (Format_Alpha8) of the avatar circle and of the half avatar
+// rectangles.
+QImage circleMask(int size);
+QImage halfMask(const QSize& size, bool leftSide);
+
+// The size x size circle cut from photo, starting at column xOffset.
+QImage circleCrop(const QImage& photo, int size, int xOffset = 0);
+// The left or right half of image.
+QImage halfCrop(const QImage& image, bool leftSide);
+// The left half of left next to the right half of right, both of the
+// same size.
+QImage splitCrop(const QImage& left, const QImage& right);
+
+} // namespace ImageKernels
@@ -287,18 +287,6 @@ LRCInstance::getCurrAccConfig()
     return getCurrentAccountInfo().confProperties;
 }
 
-int
-LRCInstance::indexOf(const QString& convId)
-{
-    auto& convs = getCurrentConversationModel()->getConversations();
-    auto it = std::find_if(convs.begin(),
-                           convs.end(),
-                           [convId](const lrc::api::conversation::Info& conv) {
-                               return conv.uid == convId;
-                           });
-    return it != convs.end() ? std::distance(convs.begin(), it) : -1;
-}
-
 void
 LRCInstance::subscribeToDebugReceived()
 {
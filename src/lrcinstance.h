@@ -112,7 +112,6 @@ public:
     int getCurrentAccountIndex();
     void setCurrAccDisplayName(const QString& displayName);
     const account::ConfProperties_t& getCurrAccConfig();
-    int indexOf(const QString& convId);
 
     void startAudioMeter();
     void stopAudioMeter();
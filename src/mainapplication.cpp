@@ -27,6 +27,7 @@
 #include "systemtray.h"
 #include "previewengine.h"
 #include "videoprovider.h"
+#include "thumbnailcache.h"
 
 #include <QAction>
 #include <QCommandLineParser>
@@ -38,6 +39,7 @@
 #include <QTranslator>
 #include <QLibraryInfo>
 #include <QQuickWindow>
+#include <QtConcurrent/QtConcurrent>
 
 #include <locale.h>
 #include <thread>
@@ -229,6 +231,9 @@ void
 MainApplication::initLrc(const QString& downloadUrl, ConnectivityMonitor* cm, bool logDaemon)
 {
     lrc::api::Lrc::cacheAvatars.store(false);
+    // Avatars are decoded and scaled by the client, whose thumbnails are
+    // cached on disk. Map them while the daemon starts.
+    std::ignore = QtConcurrent::run([] { ThumbnailCache::instance().load(); });
     /*
      * Init mainwindow and finish splash when mainwindow shows up.
      */
@@ -342,6 +347,13 @@ MainApplication::initQmlLayer()
                          this);
 
     auto videoProvider = new VideoProvider(lrcInstance_->avModel(), this);
+    videoProvider->setFramePoolSize(
+        settingsManager_->getValue(Settings::Key::VideoFramePoolSize).toInt());
+    videoProvider->setPixelFormat(
+        settingsManager_->getValue(Settings::Key::VideoPixelFormat).toString());
+    // The budget setting is in MiB.
+    videoProvider->setMemoryBudget(
+        settingsManager_->getValue(Settings::Key::VideoMemoryBudget).toLongLong() * 1024 * 1024);
     engine_->rootContext()->setContextProperty("videoProvider", videoProvider);
 
     engine_->load(QUrl(QStringLiteral("qrc:/src/MainApplicationWindow.qml")));
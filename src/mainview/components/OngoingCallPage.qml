@@ -341,6 +341,23 @@ Rectangle {
                     }
                 }
 
+                VideoStatsOverlay {
+                    id: videoStatsOverlay
+
+                    anchors.left: parent.left
+                    anchors.top: parent.top
+                    anchors.margins: previewMargin
+
+                    visible: false
+                }
+
+                Shortcut {
+                    sequence: "Ctrl+Shift+I"
+                    context: Qt.ApplicationShortcut
+                    enabled: root.visible
+                    onActivated: videoStatsOverlay.visible = !videoStatsOverlay.visible
+                }
+
                 ColumnLayout {
                     id: audioCallPageRectCentralRect
                     anchors.centerIn: parent
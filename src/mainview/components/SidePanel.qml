@@ -293,6 +293,28 @@ Rectangle {
             model: ConversationListModel
             headerLabel: JamiStrings.conversations
             headerVisible: searchResultsListView.visible
+
+            // Prefetch the avatars around the visible rows, at the pixel
+            // size requested by the delegates' Avatar (sourceSize * dpr).
+            property int firstVisibleRow: -1
+            property int lastVisibleRow: -1
+
+            function updateVisibleRange() {
+                var first = indexAt(0, contentY)
+                var last = indexAt(0, contentY + height - 1)
+                if (first === firstVisibleRow && last === lastVisibleRow)
+                    return
+                firstVisibleRow = first
+                lastVisibleRow = last
+                var avatarSize = Math.round(Math.max(24, JamiTheme.smartListAvatarSize)
+                                            * CurrentScreenInfo.devicePixelRatio)
+                ConversationListModel.setVisibleRange(first, last,
+                                                      Qt.size(avatarSize, avatarSize))
+            }
+
+            onContentYChanged: updateVisibleRange()
+            onHeightChanged: updateVisibleRange()
+            onCountChanged: updateVisibleRange()
         }
     }
 
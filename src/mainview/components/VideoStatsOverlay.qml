@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2022 Savoir-faire Linux Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+import QtQuick
+
+import net.jami.Constants 1.1
+
+// Debug overlay showing the video pipeline statistics of every
+// active renderer. Clicking it dumps the statistics to the log.
+Rectangle {
+    id: root
+
+    property var stats: []
+
+    function refresh() {
+        var result = []
+        for (var id in videoProvider.activeRenderers) {
+            var s = videoProvider.rendererStats(id)
+            result.push(id + "\n"
+                        + "  fps: " + (s.fps || 0).toFixed(1)
+                        + "  delivered: " + s.framesDelivered
+                        + "  dropped: " + s.framesDropped + "\n"
+                        + "  latency: " + s.latencyUs + " us (avg " + s.avgLatencyUs + ")"
+                        + "  queue: " + s.lastQueueDelayUs + " us (max " + s.maxQueueDelayUs + ")\n"
+                        + "  copied: " + s.bytesCopied + " B"
+                        + "  saved: " + s.bytesSaved + " B"
+                        + "  subscribers: " + s.subscribers
+                        + "  memory: " + s.memoryBytes + " B")
+        }
+        var m = videoProvider.memoryStats()
+        result.push("video buffers: " + m.bytes + " B (budget " + m.budget + " B)"
+                    + "  renderers: " + m.renderers + " (" + m.idleRenderers + " idle)"
+                    + "  evictions: " + m.evictions)
+        stats = result
+    }
+
+    width: statsText.implicitWidth + 2 * JamiTheme.preferredMarginSize
+    height: statsText.implicitHeight + 2 * JamiTheme.preferredMarginSize
+
+    radius: JamiTheme.primaryRadius
+    color: Qt.rgba(0, 0, 0, 0.6)
+
+    onVisibleChanged: if (visible) refresh()
+
+    Timer {
+        interval: 1000
+        repeat: true
+        running: root.visible
+        onTriggered: root.refresh()
+    }
+
+    Text {
+        id: statsText
+
+        anchors.centerIn: parent
+
+        font.family: "monospace"
+        font.pointSize: JamiTheme.textFontSize
+        color: "white"
+        text: root.stats.join("\n")
+    }
+
+    TapHandler {
+        onTapped: videoProvider.logRendererStats()
+    }
+}
@@ -41,6 +41,9 @@ BaseModalDialog {
 
         smooth: false
         fillMode: Image.PreserveAspectFit
-        source: "image://qrImage/account_" + CurrentAccount.id
+        // Vector code, rasterized at the resolution of the screen.
+        sourceSize.width: JamiTheme.qrCodeImageSize
+        sourceSize.height: JamiTheme.qrCodeImageSize
+        source: UtilsAdapter.getAccountQrCodeSvg(CurrentAccount.id)
     }
 }
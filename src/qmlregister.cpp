@@ -178,8 +178,15 @@ registerTypes(QQmlEngine* engine,
     QML_REGISTERSINGLETONTYPE_POBJECT(NS_CONSTANTS, settingsManager, "AppSettingsManager")
 
     auto avatarRegistry = new AvatarRegistry(lrcInstance, parent);
+    avatarRegistry->imageCache().setMaxBytes(
+        settingsManager->getValue(Settings::Key::AvatarCacheSize).toLongLong() * 1024 * 1024);
     auto wizardViewStepModel = new WizardViewStepModel(lrcInstance, accountAdapter, settingsManager, parent);
     QML_REGISTERSINGLETONTYPE_POBJECT(NS_HELPERS, avatarRegistry, "AvatarRegistry");
+    // Avatars around the visible conversations are loaded ahead of the view.
+    QObject::connect(conversationsAdapter->conversationListModel(),
+                     &ConversationListProxyModel::avatarPrefetchRequested,
+                     avatarRegistry,
+                     &AvatarRegistry::prefetchConversations);
     QML_REGISTERSINGLETONTYPE_POBJECT(NS_MODELS, wizardViewStepModel, "WizardViewStepModel")
 
     // C++ singletons
@@ -219,7 +226,8 @@ registerTypes(QQmlEngine* engine,
 
     engine->addImageProvider(QLatin1String("qrImage"), new QrImageProvider(lrcInstance));
     engine->addImageProvider(QLatin1String("avatarImage"),
-                              new AvatarImageProvider(lrcInstance));
+                              new AvatarImageProvider(lrcInstance,
+                                                      &avatarRegistry->imageCache()));
 
     engine->setObjectOwnership(&lrcInstance->avModel(), QQmlEngine::CppOwnership);
     engine->setObjectOwnership(&lrcInstance->pluginModel(), QQmlEngine::CppOwnership);
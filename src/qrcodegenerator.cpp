@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2022 Savoir-faire Linux Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "qrcodegenerator.h"
+
+#include "imagecache.h"
+
+#include <qrencode.h>
+
+#include <QCache>
+#include <QDebug>
+#include <QMutex>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Dark modules of an encoded string, one byte per module, row major.
+struct Modules
+{
+    int width {0};
+    QByteArray dark;
+};
+
+Modules
+encode(const QString& data)
+{
+    static QMutex mutex;
+    static QCache<QString, Modules> cache(32);
+
+    QMutexLocker lk(&mutex);
+    if (auto* modules = cache.object(data))
+        return *modules;
+    lk.unlock();
+
+    auto qrcode = QRcode_encodeString(data.toStdString().c_str(),
+                                      0,            // Let the version be decided by libqrencode
+                                      QR_ECLEVEL_L, // Lowest level of error correction
+                                      QR_MODE_8,    // 8-bit data mode
+                                      1);
+    if (not qrcode) {
+        qWarning() << "Failed to generate QR code";
+        return {};
+    }
+
+    auto* modules = new Modules;
+    modules->width = qrcode->width;
+    modules->dark.resize(qrcode->width * qrcode->width);
+    for (int i = 0; i < modules->dark.size(); ++i)
+        modules->dark[i] = qrcode->data[i] & 0x1;
+    QRcode_free(qrcode);
+
+    Modules result = *modules;
+    lk.relock();
+    cache.insert(data, modules);
+    return result;
+}
+
+// Sets the bits [from, to) of a Format_Mono scanline (most significant
+// bit first).
+void
+setBits(uchar* line, int from, int to)
+{
+    while (from < to && (from & 7)) {
+        line[from >> 3] |= 0x80 >> (from & 7);
+        ++from;
+    }
+    if (to - from >= 8) {
+        std::memset(line + (from >> 3), 0xff, (to - from) >> 3);
+        from += (to - from) & ~7;
+    }
+    while (from < to) {
+        line[from >> 3] |= 0x80 >> (from & 7);
+        ++from;
+    }
+}
+
+} // namespace
+
+namespace QrCodeGenerator {
+
+QImage
+image(const QString& data, int size, int margin)
+{
+    static ImageCache cache(4 * 1024 * 1024);
+
+    auto key = QString("%1_%2_%3").arg(size).arg(margin).arg(data);
+    auto result = cache.find(key);
+    if (!result.isNull())
+        return result;
+
+    auto modules = encode(data);
+    if (!modules.width)
+        return {};
+
+    auto total = modules.width + 2 * margin;
+    auto scale = std::max(1, size / total);
+    auto side = std::max(size, total * scale);
+    // Centered, the remainder of the division becomes extra margin.
+    auto origin = (side - modules.width * scale) / 2;
+
+    result = QImage(side, side, QImage::Format_Mono);
+    result.setColorTable({qRgb(255, 255, 255), qRgb(0, 0, 0)});
+    result.fill(0);
+
+    for (int y = 0; y < modules.width; ++y) {
+        auto* row = modules.dark.constData() + y * modules.width;
+        auto* line = result.scanLine(origin + y * scale);
+        for (int x = 0; x < modules.width;) {
+            if (!row[x]) {
+                ++x;
+                continue;
+            }
+            // Write each run of dark modules at once.
+            auto end = x + 1;
+            while (end < modules.width && row[end])
+                ++end;
+            setBits(line, origin + x * scale, origin + end * scale);
+            x = end;
+        }
+        for (int i = 1; i < scale; ++i)
+            std::memcpy(result.scanLine(origin + y * scale + i), line, result.bytesPerLine());
+    }
+
+    cache.insert(key, result);
+    return result;
+}
+
+QByteArray
+svg(const QString& data, int margin)
+{
+    auto modules = encode(data);
+    if (!modules.width)
+        return {};
+
+    auto total = QByteArray::number(modules.width + 2 * margin);
+    QByteArray path;
+    for (int y = 0; y < modules.width; ++y) {
+        auto* row = modules.dark.constData() + y * modules.width;
+        for (int x = 0; x < modules.width;) {
+            if (!row[x]) {
+                ++x;
+                continue;
+            }
+            auto end = x + 1;
+            while (end < modules.width && row[end])
+                ++end;
+            auto run = QByteArray::number(end - x);
+            path += "M" + QByteArray::number(margin + x) + " " + QByteArray::number(margin + y)
+                    + "h" + run + "v1h-" + run + "z";
+            x = end;
+        }
+    }
+
+    return "<svg xmlns=\"http://www.w3.org/2000/svg\" viewBox=\"0 0 " + total + " " + total
+           + "\" shape-rendering=\"crispEdges\"><rect width=\"" + total + "\" height=\"" + total
+           + "\" fill=\"#fff\"/><path fill=\"#000\" d=\"" + path + "\"/></svg>";
+}
+
+} // namespace QrCodeGenerator
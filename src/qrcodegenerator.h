@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2022 Savoir-faire Linux Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QImage>
+#include <QString>
+
+// QR codes of a string, written module by module straight into the
+// scanlines of a 1-bit image at an integer module scale, so that they
+// stay sharp without rescaling. Encodings and images are cached.
+namespace QrCodeGenerator {
+
+// The code of data in a size x size image, modules scaled by the largest
+// integer fitting size and centered. With size 0, one pixel per module.
+// margin is the number of light modules around the code. Null if data
+// cannot be encoded. May be called from any thread.
+QImage image(const QString& data, int size = 0, int margin = 0);
+
+// The code of data as an SVG document of one unit per module, to be
+// rendered at any resolution. Empty if data cannot be encoded.
+QByteArray svg(const QString& data, int margin = 0);
+
+} // namespace QrCodeGenerator
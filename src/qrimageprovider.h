@@ -20,6 +20,7 @@
 
 #include "quickimageproviderbase.h"
 #include "accountlistmodel.h"
+#include "qrcodegenerator.h"
 
 #include <QPair>
 #include <QString>
@@ -88,9 +89,12 @@ public:
             }
         }
 
+        // Modules are drawn at the requested scale rather than rescaled.
         if (!requestedSize.isEmpty())
-            return Utils::setupQRCode(uri, 0).scaled(requestedSize, Qt::KeepAspectRatio);
+            return QrCodeGenerator::image(uri,
+                                          std::min(requestedSize.width(),
+                                                   requestedSize.height()));
         else
-            return Utils::setupQRCode(uri, 0);
+            return QrCodeGenerator::image(uri);
     }
 };
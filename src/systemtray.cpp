@@ -178,7 +178,7 @@ SystemTray::showNotification(const QString& id,
                              const QString& title,
                              const QString& body,
                              NotificationType type,
-                             const QByteArray& avatar)
+                             const QImage& avatar)
 {
     if (!settingsManager_->getValue(Settings::Key::EnableNotifications).toBool())
         return;
@@ -195,15 +195,24 @@ SystemTray::showNotification(const QString& id,
 
     pimpl_->notifications.emplace(id, n);
 
-    if (!avatar.isEmpty()) {
-        GError* error = nullptr;
-        GdkPixbuf* pixbuf = nullptr;
-        GInputStream* stream = nullptr;
-        stream = g_memory_input_stream_new_from_data(avatar.constData(), avatar.size(), NULL);
-        pixbuf = gdk_pixbuf_new_from_stream(stream, nullptr, &error);
-        g_input_stream_close(stream, nullptr, nullptr);
-        g_object_unref(stream);
+    if (!avatar.isNull()) {
+        // Hand the pixels to the pixbuf as is, the image is kept alive
+        // until the pixbuf is released.
+        auto* pixels = new QImage(avatar.format() == QImage::Format_RGBA8888
+                                      ? avatar
+                                      : avatar.convertToFormat(QImage::Format_RGBA8888));
+        GdkPixbuf* pixbuf = gdk_pixbuf_new_from_data(
+            pixels->constBits(),
+            GDK_COLORSPACE_RGB,
+            TRUE,
+            8,
+            pixels->width(),
+            pixels->height(),
+            pixels->bytesPerLine(),
+            [](guchar*, gpointer image) { delete static_cast<QImage*>(image); },
+            pixels);
         notify_notification_set_image_from_pixbuf(notification.get(), pixbuf);
+        g_object_unref(pixbuf);
     }
 
     if (type != NotificationType::CHAT) {
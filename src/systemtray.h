@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <QImage>
 #include <QSystemTrayIcon>
 
 #include <functional>
@@ -44,7 +45,7 @@ public:
                           const QString& title,
                           const QString& body,
                           NotificationType type,
-                          const QByteArray& avatar = {});
+                          const QImage& avatar = {});
 
 Q_SIGNALS:
     void openConversationActivated(const QString& accountId, const QString& convUid);
@@ -0,0 +1,282 @@
+/*
+ * Copyright (C) 2022 Savoir-faire Linux Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "thumbnailcache.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <utility>
+
+namespace {
+
+constexpr quint32 kMagic = 0x4254484a; // "JTHB"
+constexpr quint32 kVersion = 1;
+constexpr qint64 kMaxBytes = 64 * 1024 * 1024;
+
+// Padded to keep the pixel data 16 bytes aligned in the mapping.
+struct Header
+{
+    quint32 magic;
+    quint32 version;
+    qint32 width;
+    qint32 height;
+    qint32 bytesPerLine;
+    quint32 reserved[3];
+};
+static_assert(sizeof(Header) == 32);
+
+void
+unmapThumbnail(void* file)
+{
+    // Destroying the QFile releases its mapping.
+    delete static_cast<QFile*>(file);
+}
+
+} // namespace
+
+ThumbnailCache&
+ThumbnailCache::instance()
+{
+    static ThumbnailCache instance;
+    return instance;
+}
+
+ThumbnailCache::ThumbnailCache()
+    : path_(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/thumbnails/")
+{
+    QDir().mkpath(path_);
+}
+
+QByteArray
+ThumbnailCache::contentHash(const QString& data)
+{
+    // Hash the UTF-16 data as is, converting it would cost more.
+    QByteArrayView bytes(reinterpret_cast<const char*>(data.utf16()),
+                         data.size() * static_cast<qsizetype>(sizeof(char16_t)));
+    return QCryptographicHash::hash(bytes, QCryptographicHash::Sha1).toHex();
+}
+
+void
+ThumbnailCache::load()
+{
+    QDir dir(path_);
+    // The file time is refreshed on first use in a session, sorting by it
+    // puts the most recently used thumbnails first.
+    auto files = dir.entryInfoList({"*.thumb"}, QDir::Files, QDir::Time);
+    qint64 total = 0;
+    QList<std::pair<QString, QImage>> images;
+    for (const auto& fileInfo : files) {
+        total += fileInfo.size();
+        if (total > kMaxBytes) {
+            QFile::remove(fileInfo.absoluteFilePath());
+            continue;
+        }
+        auto image = mapFile(fileInfo.absoluteFilePath());
+        if (image.isNull()) {
+            QFile::remove(fileInfo.absoluteFilePath());
+            continue;
+        }
+        images.append({fileInfo.fileName(), image});
+    }
+
+    QMutexLocker lk(&mutex_);
+    // Entries found or inserted meanwhile are more recent than the files.
+    for (const auto& [name, image] : std::as_const(images)) {
+        if (!images_.contains(name)) {
+            addEntry(name, image, false);
+        }
+    }
+    auto evicted = evict();
+    lk.unlock();
+    removeFiles(evicted);
+}
+
+QImage
+ThumbnailCache::find(const QByteArray& hash, const QSize& size)
+{
+    auto name = fileName(hash, size);
+    QMutexLocker lk(&mutex_);
+    auto it = images_.find(name);
+    if (it != images_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->lru);
+        auto image = it->image;
+        if (it->touched) {
+            return image;
+        }
+        it->touched = true;
+        lk.unlock();
+        touchFile(name);
+        return image;
+    }
+    lk.unlock();
+
+    // Written since the startup load.
+    auto image = mapFile(path_ + name);
+    if (image.isNull()) {
+        return image;
+    }
+    touchFile(name);
+    lk.relock();
+    addEntry(name, image, true);
+    auto evicted = evict();
+    lk.unlock();
+    removeFiles(evicted);
+    return image;
+}
+
+void
+ThumbnailCache::insert(const QByteArray& hash, const QSize& size, const QImage& image)
+{
+    if (image.isNull()) {
+        return;
+    }
+    auto thumbnail = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    Header header {kMagic,
+                   kVersion,
+                   thumbnail.width(),
+                   thumbnail.height(),
+                   static_cast<qint32>(thumbnail.bytesPerLine()),
+                   {}};
+    // Written to a temporary file then renamed, concurrent writers of the
+    // same thumbnail and readers never see a partial file.
+    auto name = fileName(hash, size);
+    QSaveFile file(path_ + name);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(thumbnail.constBits()), thumbnail.sizeInBytes());
+    if (!file.commit()) {
+        qWarning() << "Can't write thumbnail" << file.fileName();
+        return;
+    }
+
+    // Accounted right away, the limit holds without waiting for a restart.
+    auto mapped = mapFile(path_ + name);
+    if (mapped.isNull()) {
+        return;
+    }
+    QMutexLocker lk(&mutex_);
+    addEntry(name, mapped, true);
+    auto evicted = evict();
+    lk.unlock();
+    removeFiles(evicted);
+}
+
+void
+ThumbnailCache::addEntry(const QString& name, const QImage& image, bool recent)
+{
+    // Replaces a thumbnail rewritten by a concurrent insert.
+    removeEntry(name);
+    auto bytes = qint64(sizeof(Header)) + image.sizeInBytes();
+    auto lru = recent ? lru_.insert(lru_.begin(), name) : lru_.insert(lru_.end(), name);
+    images_.insert(name, {image, bytes, lru, recent});
+    bytes_ += bytes;
+}
+
+void
+ThumbnailCache::removeEntry(const QString& name)
+{
+    auto it = images_.find(name);
+    if (it == images_.end()) {
+        return;
+    }
+    bytes_ -= it->bytes;
+    lru_.erase(it->lru);
+    images_.erase(it);
+}
+
+QStringList
+ThumbnailCache::evict()
+{
+    QStringList evicted;
+    while (bytes_ > kMaxBytes && !lru_.empty()) {
+        // Dropping the image unmaps the file once the images handed out
+        // are released as well.
+        auto name = lru_.back();
+        removeEntry(name);
+        evicted.append(name);
+    }
+    return evicted;
+}
+
+void
+ThumbnailCache::touchFile(const QString& name) const
+{
+    QFile file(path_ + name);
+    if (file.open(QIODevice::ReadOnly)) {
+        file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    }
+}
+
+void
+ThumbnailCache::removeFiles(const QStringList& names) const
+{
+    // Mapped files can be removed on Unix. Elsewhere a file still mapped by
+    // an image in use is left for the next startup pruning.
+    for (const auto& name : names) {
+        QFile::remove(path_ + name);
+    }
+}
+
+QString
+ThumbnailCache::fileName(const QByteArray& hash, const QSize& size) const
+{
+    return QString("%1_%2x%3.thumb")
+        .arg(QString::fromLatin1(hash))
+        .arg(size.width())
+        .arg(size.height());
+}
+
+QImage
+ThumbnailCache::mapFile(const QString& fileName) const
+{
+    auto file = new QFile(fileName);
+    auto fileSize = file->size();
+    if (fileSize < qint64(sizeof(Header)) || !file->open(QIODevice::ReadOnly)) {
+        delete file;
+        return {};
+    }
+    auto data = file->map(0, fileSize);
+    // The mapping outlives the file descriptor.
+    file->close();
+    if (!data) {
+        delete file;
+        return {};
+    }
+    auto header = reinterpret_cast<const Header*>(data);
+    auto pixelBytes = static_cast<qint64>(header->bytesPerLine) * header->height;
+    if (header->magic != kMagic || header->version != kVersion || header->width <= 0
+        || header->height <= 0 || header->bytesPerLine < header->width * 4
+        || fileSize != qint64(sizeof(Header)) + pixelBytes) {
+        delete file;
+        return {};
+    }
+    // The image is read-only, a write would detach a copy.
+    return QImage(static_cast<const uchar*>(data + sizeof(Header)),
+                  header->width,
+                  header->height,
+                  header->bytesPerLine,
+                  QImage::Format_ARGB32_Premultiplied,
+                  unmapThumbnail,
+                  file);
+}
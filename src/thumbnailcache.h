@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2022 Savoir-faire Linux Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+#include <list>
+
+// Disk cache of pre-scaled, premultiplied avatar thumbnails, persisted
+// across restarts under the application cache directory. Thumbnails are
+// keyed by a hash of the encoded source data and by their size, so they
+// are invalidated by a content change only. Each file holds the raw
+// pixels after a small header and is memory-mapped: a hit costs neither
+// decoding nor copying. The files are bounded in size, the least recently
+// used ones are unmapped and removed first.
+class ThumbnailCache
+{
+public:
+    static ThumbnailCache& instance();
+
+    // Hash identifying the content of an encoded image.
+    static QByteArray contentHash(const QString& data);
+
+    // Maps the cached thumbnails, pruning the least recently used files
+    // beyond the size limit. Called once at startup, may run on any thread.
+    void load();
+
+    // Returns a null image on a miss.
+    QImage find(const QByteArray& hash, const QSize& size);
+    void insert(const QByteArray& hash, const QSize& size, const QImage& image);
+
+private:
+    ThumbnailCache();
+
+    QString fileName(const QByteArray& hash, const QSize& size) const;
+    QImage mapFile(const QString& fileName) const;
+
+    struct Entry
+    {
+        QImage image;
+        qint64 bytes;
+        std::list<QString>::iterator lru;
+        // Whether the file time was refreshed during this session.
+        bool touched;
+    };
+
+    // All called with the mutex locked.
+    void addEntry(const QString& name, const QImage& image, bool recent);
+    void removeEntry(const QString& name);
+    QStringList evict();
+
+    void touchFile(const QString& name) const;
+    void removeFiles(const QStringList& names) const;
+
+    QString path_;
+    QMutex mutex_;
+    // Mapped thumbnails by file name.
+    QHash<QString, Entry> images_;
+    // File names, most recently used first.
+    std::list<QString> lru_;
+    qint64 bytes_ {0};
+};
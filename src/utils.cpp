@@ -24,14 +24,21 @@
 
 #include "jamiavatartheme.h"
 #include "lrcinstance.h"
-
-#include <qrencode.h>
+#include "thumbnailcache.h"
+#include "imagecache.h"
+#include "imagekernels.h"
+#include "base64.h"
+#include "qrcodegenerator.h"
 
 #include <QApplication>
 #include <QBitmap>
+#include <QBuffer>
+#include <QCache>
 #include <QErrorMessage>
 #include <QFile>
+#include <QImageReader>
 #include <QMessageBox>
+#include <QMutex>
 #include <QObject>
 #include <QPainter>
 #include <QPropertyAnimation>
@@ -39,6 +46,7 @@
 #include <QDateTime>
 #include <QSvgRenderer>
 #include <QTranslator>
+#include <QtMath>
 #include <QtConcurrent/QtConcurrent>
 #include <QUuid>
 
@@ -332,7 +340,7 @@ Utils::accountPhoto(LRCInstance* instance, const QString& accountId, const QSize
         auto& accInfo = instance->accountModel().getAccountInfo(
             accountId.isEmpty() ? instance->get_currentAccountId() : accountId);
         if (!accInfo.profileInfo.avatar.isEmpty()) {
-            photo = imageFromBase64String(accInfo.profileInfo.avatar);
+            return avatarFromBase64String(accInfo.profileInfo.avatar, size);
         } else {
             auto bestName = instance->accountModel().bestNameForAccount(accInfo.id);
             QString name = bestName == accInfo.profileInfo.uri ? QString() : bestName;
@@ -366,11 +374,11 @@ Utils::contactPhoto(LRCInstance* instance,
                    && contactInfo.profileInfo.uri.isEmpty()) {
             photo = Utils::fallbackAvatar(QString(), QString());
         } else if (!contactPhoto.isEmpty()) {
-            photo = imageFromBase64String(contactPhoto);
-            if (photo.isNull()) {
-                auto avatarName = contactInfo.profileInfo.uri == bestName ? QString() : bestName;
-                photo = Utils::fallbackAvatar("jami:" + contactInfo.profileInfo.uri, avatarName);
-            }
+            photo = avatarFromBase64String(contactPhoto, size);
+            if (!photo.isNull())
+                return photo;
+            auto avatarName = contactInfo.profileInfo.uri == bestName ? QString() : bestName;
+            photo = Utils::fallbackAvatar("jami:" + contactInfo.profileInfo.uri, avatarName);
         } else {
             auto avatarName = contactInfo.profileInfo.uri == bestName ? QString() : bestName;
             photo = Utils::fallbackAvatar("jami:" + contactInfo.profileInfo.uri, avatarName);
@@ -397,7 +405,7 @@ Utils::conversationAvatar(LRCInstance* instance,
         auto* convModel = accInfo.conversationModel.get();
         auto avatarb64 = convModel->avatar(convId);
         if (!avatarb64.isEmpty())
-            return scaleAndFrame(imageFromBase64String(avatarb64, true), size);
+            return avatarFromBase64String(avatarb64, size);
         // Else, generate an avatar
         auto members = convModel->peersForConversation(convId);
         if (members.size() < 1)
@@ -409,9 +417,10 @@ Utils::conversationAvatar(LRCInstance* instance,
             return avatar;
         }
         // Else, combine avatars
-        auto idx = 0;
         auto peerAAvatar = Utils::contactPhoto(instance, members[0], size, "");
         auto peerBAvatar = Utils::contactPhoto(instance, members[1], size, "");
+        if (peerAAvatar.size() == size && peerBAvatar.size() == size)
+            return ImageKernels::splitCrop(peerAAvatar, peerBAvatar);
         peerAAvatar = Utils::halfCrop(peerAAvatar, true);
         peerBAvatar = Utils::halfCrop(peerBAvatar, false);
         painter.drawImage(avatar.rect(), peerAAvatar);
@@ -429,21 +438,124 @@ Utils::tempConversationAvatar(const QSize& size)
                                      + "tmpSwarmImage");
     if (img.isEmpty())
         return fallbackAvatar(QString(), QString(), size);
-    return scaleAndFrame(imageFromBase64String(img, true), size);
+    return avatarFromBase64String(img, size);
+}
+
+QString
+Utils::avatarUid(LRCInstance* instance, const QString& id, const QString& accountId)
+{
+    // qHash is enough here: the uid only has to change with the data
+    // within this process, and hashing the base64 avatar is much cheaper
+    // than decoding it again.
+    size_t hash = 0;
+    try {
+        if (id == "temp") {
+            hash = qHash(QByteArrayFromFile(
+                QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+                + "tmpSwarmImage"));
+            return QString::number(hash, 16);
+        }
+
+        auto& accountModel = instance->accountModel();
+        if (accountModel.getAccountList().contains(id)) {
+            auto& accInfo = accountModel.getAccountInfo(id);
+            hash = qHashMulti(0,
+                              accInfo.profileInfo.avatar,
+                              accountModel.bestNameForAccount(id),
+                              accInfo.profileInfo.uri,
+                              static_cast<int>(accInfo.profileInfo.type));
+            return QString::number(hash, 16);
+        }
+
+        auto& accInfo = accountModel.getAccountInfo(
+            accountId.isEmpty() ? instance->get_currentAccountId() : accountId);
+        auto contactHash = [&](const QString& uri) {
+            auto contactInfo = accInfo.contactModel->getContact(uri);
+            return qHashMulti(0,
+                              accInfo.contactModel->avatar(uri),
+                              accInfo.contactModel->bestNameForContact(uri),
+                              static_cast<int>(contactInfo.profileInfo.type));
+        };
+
+        auto& convInfo = instance->getConversationFromConvUid(id, accInfo.id);
+        if (!convInfo.uid.isEmpty()) {
+            // Generated avatars show at most two peers.
+            auto* convModel = accInfo.conversationModel.get();
+            hash = qHash(convModel->avatar(id));
+            auto members = convModel->peersForConversation(id);
+            for (int i = 0; i < std::min<int>(members.size(), 2); ++i)
+                hash = qHashMulti(hash, members[i], contactHash(members[i]));
+            return QString::number(hash, 16);
+        }
+
+        hash = contactHash(id);
+    } catch (const std::exception& e) {
+        qDebug() << Q_FUNC_INFO << e.what();
+    }
+    return QString::number(hash, 16);
 }
 
 QImage
-Utils::imageFromBase64String(const QString& str, bool circleCrop)
+Utils::notificationAvatar(LRCInstance* instance, const QString& id, const QString& accountId)
 {
-    return imageFromBase64Data(Utils::base64StringToByteArray(str), circleCrop);
+    static ImageCache cache(1024 * 1024);
+    static const QSize size(50, 50);
+
+    auto key = QString("%1_%2_%3").arg(accountId, id, avatarUid(instance, id, accountId));
+    auto icon = cache.find(key);
+    if (!icon.isNull())
+        return icon;
+
+    auto& convInfo = instance->getConversationFromConvUid(id, accountId);
+    if (!convInfo.uid.isEmpty())
+        icon = conversationAvatar(instance, id, size, accountId);
+    else
+        icon = contactPhoto(instance, id, size, accountId);
+    icon = icon.convertToFormat(QImage::Format_RGBA8888);
+    cache.insert(key, icon);
+    return icon;
 }
 
 QImage
-Utils::imageFromBase64Data(const QByteArray& data, bool circleCrop)
+Utils::avatarFromBase64String(const QString& str, const QSize& size)
 {
-    QImage img;
+    auto& cache = ThumbnailCache::instance();
+    auto hash = ThumbnailCache::contentHash(str);
+    auto thumbnail = cache.find(hash, size);
+    if (!thumbnail.isNull())
+        return thumbnail;
+    thumbnail = scaleAndFrame(imageFromBase64String(str, true, size), size);
+    cache.insert(hash, size, thumbnail);
+    return thumbnail;
+}
+
+QImage
+Utils::imageFromBase64String(const QString& str, bool circleCrop, const QSize& coverSize)
+{
+    return imageFromBase64Data(Utils::base64StringToByteArray(str), circleCrop, coverSize);
+}
 
-    if (img.loadFromData(data)) {
+QImage
+Utils::imageFromBase64Data(const QByteArray& data, bool circleCrop, const QSize& coverSize)
+{
+    QBuffer buffer;
+    buffer.setData(data);
+    QImageReader reader(&buffer);
+
+    // Only the header is read here. The decoder then downscales while
+    // decoding (in the DCT domain for JPEG) rather than allocating the
+    // full size image.
+    auto sourceSize = reader.size();
+    auto target = std::max(coverSize.width(), coverSize.height());
+    auto shorterSide = std::min(sourceSize.width(), sourceSize.height());
+    if (target > 0 && shorterSide > target) {
+        auto factor = static_cast<qreal>(target) / shorterSide;
+        reader.setScaledSize(QSize(std::max(target, qCeil(sourceSize.width() * factor)),
+                                   std::max(target, qCeil(sourceSize.height() * factor))));
+    }
+
+    QImage img;
+    if (reader.read(&img)) {
         if (circleCrop) {
             return Utils::getCirclePhoto(img, img.size().width());
         }
@@ -457,12 +569,6 @@ Utils::imageFromBase64Data(const QByteArray& data, bool circleCrop)
 QImage
 Utils::getCirclePhoto(const QImage original, int sizePhoto)
 {
-    QImage target(sizePhoto, sizePhoto, QImage::Format_ARGB32_Premultiplied);
-    target.fill(Qt::transparent);
-
-    QPainter painter(&target);
-    painter.setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform);
-    painter.setBrush(QBrush(Qt::white));
     auto scaledPhoto = original
                            .scaled(sizePhoto,
                                    sizePhoto,
@@ -473,27 +579,13 @@ Utils::getCirclePhoto(const QImage original, int sizePhoto)
     if (scaledPhoto.width() > sizePhoto) {
         margin = (scaledPhoto.width() - sizePhoto) / 2;
     }
-    painter.drawEllipse(0, 0, sizePhoto, sizePhoto);
-    painter.setCompositionMode(QPainter::CompositionMode_SourceIn);
-    painter.drawImage(0, 0, scaledPhoto, margin, 0);
-    return target;
+    return ImageKernels::circleCrop(scaledPhoto, sizePhoto, margin);
 }
 
 QImage
 Utils::halfCrop(const QImage original, bool leftSide)
 {
-    auto width = original.size().width();
-    auto height = original.size().height();
-    QImage target(width, height, QImage::Format_ARGB32_Premultiplied);
-    target.fill(Qt::transparent);
-
-    QPainter painter(&target);
-    painter.setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform);
-    painter.setBrush(QBrush(Qt::white));
-    painter.drawRect(leftSide ? 0 : width / 2 + 2, 0, width / 2 - (leftSide ? 2 : 0), height);
-    painter.setCompositionMode(QPainter::CompositionMode_SourceIn);
-    painter.drawImage(0, 0, original, 0, 0);
-    return target;
+    return ImageKernels::halfCrop(original, leftSide);
 }
 
 QSize
@@ -642,28 +734,49 @@ Utils::getAvatarColor(const QString& canonicalUri)
     if (canonicalUri.isEmpty()) {
         return JamiAvatarTheme::defaultAvatarColor_;
     }
+    // Memoized, the same uri is looked up for every avatar size and reload.
+    static QMutex colorsMutex;
+    static QCache<QString, QColor> colors(4096);
+    QMutexLocker lk(&colorsMutex);
+    if (auto color = colors.object(canonicalUri)) {
+        return *color;
+    }
+    lk.unlock();
+
     auto h = QString(
         QCryptographicHash::hash(canonicalUri.toLocal8Bit(), QCryptographicHash::Md5).toHex());
     if (h.isEmpty() || h.isNull()) {
         return JamiAvatarTheme::defaultAvatarColor_;
     }
     auto colorIndex = std::string("0123456789abcdef").find(h.at(0).toLatin1());
-    return JamiAvatarTheme::avatarColors_[colorIndex];
+    auto color = JamiAvatarTheme::avatarColors_[colorIndex];
+
+    lk.relock();
+    colors.insert(canonicalUri, new QColor(color));
+    return color;
 }
 
-/*!
- * Generate a QImage representing a default user avatar, when the user doesn't provide it.
- * If the name passed is empty, then the default avatar picture will be displayed instead
- * of a letter.
- *
- * @param canonicalUri uri containing the account type prefix used to obtain the bgcolor
- * @param name the string used to acquire the letter centered in the avatar
- * @param size the dimensions of the desired image
- */
-QImage
-Utils::fallbackAvatar(const QString& canonicalUri, const QString& name, const QSize& size)
+// The letter painted in a fallback avatar, empty for the default icon.
+static QString
+fallbackAvatarGlyph(const QString& name)
 {
-    auto sizeToUse = size.height() >= defaultAvatarSize.height() ? size : defaultAvatarSize;
+    QString trimmedName(name);
+    if (trimmedName.remove(QRegularExpression("[\\n\\t\\r]")).isEmpty()) {
+        return {};
+    }
+    auto unicode = trimmedName.toUcs4().at(0);
+    if (unicode >= 0x0000 && unicode <= 0x00FF) {
+        // basic Latin
+        return QString(trimmedName.at(0).toUpper());
+    }
+    return QString::fromUcs4(reinterpret_cast<char32_t*>(&unicode), 1);
+}
+
+static QImage
+paintFallbackAvatar(const QColor& color, const QString& glyph, const QSize& size)
+{
+    auto sizeToUse = size.height() >= Utils::defaultAvatarSize.height() ? size
+                                                                        : Utils::defaultAvatarSize;
 
     QImage avatar(sizeToUse, QImage::Format_ARGB32);
     avatar.fill(Qt::transparent);
@@ -673,41 +786,29 @@ Utils::fallbackAvatar(const QString& canonicalUri, const QString& name, const QS
     painter.setPen(Qt::transparent);
 
     // background circle
-    painter.setBrush(getAvatarColor(canonicalUri).lighter(110));
+    painter.setBrush(color);
     painter.drawEllipse(avatar.rect());
 
     // if a letter was passed, then we paint a letter in the circle,
     // otherwise we draw the default avatar icon
-    QString trimmedName(name);
-    if (!trimmedName.remove(QRegularExpression("[\\n\\t\\r]")).isEmpty()) {
-        auto unicode = trimmedName.toUcs4().at(0);
+    if (!glyph.isEmpty()) {
+        auto unicode = glyph.toUcs4().at(0);
         if (unicode >= 0x1F000 && unicode <= 0x1FFFF) {
             // emoticon
-            auto letter = QString::fromUcs4(reinterpret_cast<char32_t*>(&unicode), 1);
             QFont font(QString("Segoe UI Emoji").split(QLatin1Char(',')),
                        avatar.height() / 2.66667,
                        QFont::Medium);
             painter.setFont(font);
             QRect emojiRect(avatar.rect());
             emojiRect.moveTop(-6);
-            painter.drawText(emojiRect, letter, QTextOption(Qt::AlignCenter));
-        } else if (unicode >= 0x0000 && unicode <= 0x00FF) {
-            // basic Latin
-            auto letter = trimmedName.at(0).toUpper();
-            QFont font(QString("Arial").split(QLatin1Char(',')),
-                       avatar.height() / 2.66667,
-                       QFont::Medium);
-            painter.setFont(font);
-            painter.setPen(Qt::white);
-            painter.drawText(avatar.rect(), QString(letter), QTextOption(Qt::AlignCenter));
+            painter.drawText(emojiRect, glyph, QTextOption(Qt::AlignCenter));
         } else {
-            auto letter = QString::fromUcs4(reinterpret_cast<char32_t*>(&unicode), 1);
             QFont font(QString("Arial").split(QLatin1Char(',')),
                        avatar.height() / 2.66667,
                        QFont::Medium);
             painter.setFont(font);
             painter.setPen(Qt::white);
-            painter.drawText(avatar.rect(), QString(letter), QTextOption(Qt::AlignCenter));
+            painter.drawText(avatar.rect(), glyph, QTextOption(Qt::AlignCenter));
         }
     } else {
         QRect overlayRect = avatar.rect();
@@ -722,6 +823,38 @@ Utils::fallbackAvatar(const QString& canonicalUri, const QString& name, const QS
     return avatar.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
 }
 
+/*!
+ * Generate a QImage representing a default user avatar, when the user doesn't provide it.
+ * If the name passed is empty, then the default avatar picture will be displayed instead
+ * of a letter.
+ *
+ * The generated images are kept in an atlas keyed by color, glyph and pixel size, so
+ * that contacts sharing them cost a single paint.
+ *
+ * @param canonicalUri uri containing the account type prefix used to obtain the bgcolor
+ * @param name the string used to acquire the letter centered in the avatar
+ * @param size the dimensions of the desired image
+ */
+QImage
+Utils::fallbackAvatar(const QString& canonicalUri, const QString& name, const QSize& size)
+{
+    static ImageCache atlas(8 * 1024 * 1024);
+
+    auto color = getAvatarColor(canonicalUri).lighter(110);
+    auto glyph = fallbackAvatarGlyph(name);
+    auto key = QString("%1_%2x%3_%4")
+                   .arg(color.rgba())
+                   .arg(size.width())
+                   .arg(size.height())
+                   .arg(glyph);
+    auto avatar = atlas.find(key);
+    if (avatar.isNull()) {
+        avatar = paintFallbackAvatar(color, glyph, size);
+        atlas.insert(key, avatar);
+    }
+    return avatar;
+}
+
 QImage
 Utils::fallbackAvatar(const std::string& alias, const std::string& uri, const QSize& size)
 {
@@ -729,25 +862,25 @@ Utils::fallbackAvatar(const std::string& alias, const std::string& uri, const QS
 }
 
 QByteArray
-Utils::QImageToByteArray(QImage image)
+Utils::QImageToByteArray(QImage image, const char* format, int quality)
 {
     QByteArray ba;
     QBuffer buffer(&ba);
     buffer.open(QIODevice::WriteOnly);
-    image.save(&buffer, "PNG");
+    image.save(&buffer, format, quality);
     return ba;
 }
 
 QString
-Utils::byteArrayToBase64String(QByteArray byteArray)
+Utils::byteArrayToBase64String(const QByteArray& byteArray)
 {
-    return QString::fromLatin1(byteArray.toBase64().data());
+    return Base64::encodeToString(byteArray);
 }
 
 QByteArray
-Utils::base64StringToByteArray(QString base64)
+Utils::base64StringToByteArray(const QString& base64)
 {
-    return QByteArray::fromBase64(base64.toLatin1());
+    return Base64::decode(base64);
 }
 
 QImage
@@ -775,37 +908,7 @@ Utils::pixmapFromSvg(const QString& svg_resource, const QSize& size)
 QImage
 Utils::setupQRCode(QString ringID, int margin)
 {
-    auto qrcode = QRcode_encodeString(ringID.toStdString().c_str(),
-                                      0,            // Let the version be decided by libqrencode
-                                      QR_ECLEVEL_L, // Lowest level of error correction
-                                      QR_MODE_8,    // 8-bit data mode
-                                      1);
-    if (not qrcode) {
-        qWarning() << "Failed to generate QR code";
-        return QImage();
-    }
-
-    int qrwidth = qrcode->width + margin * 2;
-    QImage result(QSize(qrwidth, qrwidth), QImage::Format_Mono);
-    QPainter painter;
-    painter.begin(&result);
-    painter.setClipRect(QRect(0, 0, qrwidth, qrwidth));
-    painter.setPen(QPen(Qt::black, 0.1, Qt::SolidLine, Qt::FlatCap, Qt::MiterJoin));
-    painter.setBrush(Qt::black);
-    painter.fillRect(QRect(0, 0, qrwidth, qrwidth), Qt::white);
-    unsigned char* p;
-    p = qrcode->data;
-    for (int y = 0; y < qrcode->width; y++) {
-        unsigned char* row = (p + (y * qrcode->width));
-        for (int x = 0; x < qrcode->width; x++) {
-            if (*(row + x) & 0x1) {
-                painter.drawRect(margin + x, margin + y, 1, 1);
-            }
-        }
-    }
-    painter.end();
-    QRcode_free(qrcode);
-    return result;
+    return QrCodeGenerator::image(ringID, 0, margin);
 }
 
 QByteArray
@@ -81,8 +81,16 @@ bool getReplyMessageBox(QWidget* widget, const QString& title, const QString& te
 
 // Image manipulation
 constexpr static const QSize defaultAvatarSize {128, 128};
-QImage imageFromBase64String(const QString& str, bool circleCrop = true);
-QImage imageFromBase64Data(const QByteArray& data, bool circleCrop = true);
+// When coverSize is valid, large images are decoded downscaled, to the
+// smallest size whose shorter side still covers it.
+QImage imageFromBase64String(const QString& str,
+                             bool circleCrop = true,
+                             const QSize& coverSize = {});
+// Circle-cropped image scaled to size, through the disk thumbnail cache.
+QImage avatarFromBase64String(const QString& str, const QSize& size);
+QImage imageFromBase64Data(const QByteArray& data,
+                           bool circleCrop = true,
+                           const QSize& coverSize = {});
 QImage accountPhoto(LRCInstance* instance,
                     const QString& accountId,
                     const QSize& size = defaultAvatarSize);
@@ -98,15 +106,23 @@ QImage getCirclePhoto(const QImage original, int sizePhoto);
 QImage halfCrop(const QImage original, bool leftSide);
 QColor getAvatarColor(const QString& canonicalUri);
 QImage tempConversationAvatar(const QSize& size);
+// Hash of the avatar data and names the image of an account,
+// conversation or contact id, or "temp", is drawn from.
+QString avatarUid(LRCInstance* instance, const QString& id, const QString& accountId = {});
+// 50x50 non-premultiplied RGBA avatar of a conversation or contact for
+// the notifications, cached until its avatarUid changes.
+QImage notificationAvatar(LRCInstance* instance,
+                          const QString& id,
+                          const QString& accountId = {});
 QImage fallbackAvatar(const QString& canonicalUriStr,
                       const QString& letterStr = {},
                       const QSize& size = defaultAvatarSize);
 QImage fallbackAvatar(const std::string& alias,
                       const std::string& uri,
                       const QSize& size = defaultAvatarSize);
-QByteArray QImageToByteArray(QImage image);
-QString byteArrayToBase64String(QByteArray byteArray);
-QByteArray base64StringToByteArray(QString base64);
+QByteArray QImageToByteArray(QImage image, const char* format = "PNG", int quality = -1);
+QString byteArrayToBase64String(const QByteArray& byteArray);
+QByteArray base64StringToByteArray(const QString& base64);
 QByteArray QByteArrayFromFile(const QString& filename);
 QPixmap generateTintedPixmap(const QString& filename, QColor color);
 QPixmap generateTintedPixmap(const QPixmap& pix, QColor color);
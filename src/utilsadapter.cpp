@@ -25,6 +25,8 @@
 #include "lrcinstance.h"
 #include "systemtray.h"
 #include "utils.h"
+#include "qrcodegenerator.h"
+#include "base64.h"
 #include "version.h"
 
 #include "api/pluginmodel.h"
@@ -481,6 +483,23 @@ UtilsAdapter::supportedLang()
     return result;
 }
 
+QString
+UtilsAdapter::getAccountQrCodeSvg(const QString& accountId)
+{
+    if (accountId.isEmpty())
+        return {};
+    try {
+        auto& accountInfo = lrcInstance_->getAccountInfo(accountId);
+        auto svg = QrCodeGenerator::svg(accountInfo.profileInfo.uri);
+        if (svg.isEmpty())
+            return {};
+        return "data:image/svg+xml;base64," + svg.toBase64();
+    } catch (const std::out_of_range&) {
+        qWarning() << "Couldn't get account info for id:" << accountId;
+    }
+    return {};
+}
+
 QString
 UtilsAdapter::swarmCreationImage(const QString& imageId) const
 {
@@ -520,13 +539,13 @@ UtilsAdapter::setSwarmCreationImageFromImage(const QImage& image, const QString&
         QFile file(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
                    + "tmpSwarmImage");
         file.open(QIODevice::WriteOnly);
-        file.write(ba.toBase64());
+        file.write(Base64::encode(ba));
         file.close();
         Q_EMIT lrcInstance_->base64SwarmAvatarChanged();
     } else {
+        auto avatar = Base64::encodeToString(ba);
         lrcInstance_->getCurrentConversationModel()->updateConversationInfos(imageId,
-                                                                             {{"avatar",
-                                                                               ba.toBase64()}});
+                                                                             {{"avatar", avatar}});
     }
 }
 
@@ -92,6 +92,8 @@ public:
     Q_INVOKABLE void monitor(const bool& continuous);
     Q_INVOKABLE void clearInteractionsCache(const QString& accountId, const QString& convUid);
     Q_INVOKABLE QVariantMap supportedLang();
+    // QR code of the account uri as an SVG data url, for any resolution.
+    Q_INVOKABLE QString getAccountQrCodeSvg(const QString& accountId);
     Q_INVOKABLE QString swarmCreationImage(const QString& imageId = "temp") const;
     Q_INVOKABLE void setSwarmCreationImageFromString(const QString& image = "",
                                                      const QString& imageId = "temp");
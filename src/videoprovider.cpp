@@ -18,6 +18,12 @@
 
 #include "videoprovider.h"
 
+#include "videoscaler.h"
+
+#include <QtConcurrent/QtConcurrent>
+
+#include <algorithm>
+
 using namespace lrc::api;
 
 static bool
@@ -30,91 +36,532 @@ mapVideoFrame(QVideoFrame* videoFrame)
     return true;
 }
 
+static AVPixelFormat
+toAVPixelFormat(QVideoFrameFormat::PixelFormat format)
+{
+    switch (format) {
+    case QVideoFrameFormat::Format_YUV420P:
+        return AV_PIX_FMT_YUV420P;
+    case QVideoFrameFormat::Format_NV12:
+        return AV_PIX_FMT_NV12;
+    case QVideoFrameFormat::Format_BGRA8888:
+        return AV_PIX_FMT_BGRA;
+    default:
+        return AV_PIX_FMT_RGBA;
+    }
+}
+
+// Size of the buffer allocated for a frame of the given format.
+static qsizetype
+frameFormatBytes(const QVideoFrameFormat& format)
+{
+    auto pixels = static_cast<qsizetype>(format.frameWidth()) * format.frameHeight();
+    switch (format.pixelFormat()) {
+    case QVideoFrameFormat::Format_YUV420P:
+    case QVideoFrameFormat::Format_NV12:
+        return pixels * 3 / 2;
+    default:
+        return pixels * 4;
+    }
+}
+
+QVideoFrame*
+VideoProvider::FrameObject::acquireBackFrame()
+{
+    // The decoder asked for a new buffer without pushing the previous one,
+    // the slot can be reused as is.
+    if (writeIdx != -1) {
+        return frames.at(writeIdx).get();
+    }
+    const int poolSize = static_cast<int>(frames.size());
+    if (poolSize == 0) {
+        return nullptr;
+    }
+    // Round-robin over the pool, starting after the last written slot, so
+    // that the slot least recently handed to the sinks gets reused first.
+    // The previous front frame may still be uploaded by the render thread,
+    // it is only recycled after the next delivery.
+    for (int i = 1; i <= poolSize; ++i) {
+        auto idx = (lastWriteIdx + i) % poolSize;
+        if (idx != frontIdx && idx != previousFrontIdx && idx != readyIdx) {
+            writeIdx = idx;
+            break;
+        }
+    }
+    // Every slot is busy: drop the pending ready frame, the newest one wins.
+    // With at least 3 frames, a slot is either free or ready.
+    if (writeIdx == -1) {
+        if (readyIdx == -1) {
+            return nullptr;
+        }
+        writeIdx = readyIdx;
+        readyIdx = -1;
+        ++framesDropped;
+    }
+    lastWriteIdx = writeIdx;
+    return frames.at(writeIdx).get();
+}
+
+bool
+VideoProvider::FrameObject::publishBackFrame(qint64 timestamp)
+{
+    if (writeIdx == -1) {
+        return false;
+    }
+    // A ready frame that was never delivered gets replaced by the new one.
+    if (readyIdx != -1) {
+        frames.at(readyIdx)->unmap();
+        ++framesDropped;
+    }
+    readyIdx = writeIdx;
+    readyTimestamp = timestamp;
+    readyRequestTimestamp = requestTimestamp;
+    writeIdx = -1;
+    return true;
+}
+
+QVideoFrame*
+VideoProvider::FrameObject::takeReadyFrame()
+{
+    if (readyIdx == -1) {
+        return nullptr;
+    }
+    previousFrontIdx = frontIdx;
+    frontIdx = readyIdx;
+    readyIdx = -1;
+    return frames.at(frontIdx).get();
+}
+
+QVideoFrame*
+VideoProvider::ScaledFrames::scale(const QVideoFrame& source, int factor, int poolSize)
+{
+    auto size = VideoScaler::scaledSize(source.size(), factor);
+    if (frames.empty() || frames.front()->size() != size
+        || frames.front()->pixelFormat() != source.pixelFormat()) {
+        auto format = QVideoFrameFormat(size, source.pixelFormat());
+        frames.clear();
+        for (int i = 0; i < std::max(poolSize, 1); ++i) {
+            frames.emplace_back(std::make_unique<QVideoFrame>(format));
+        }
+        index = -1;
+    }
+    index = (index + 1) % static_cast<int>(frames.size());
+    auto videoFrame = frames.at(index).get();
+    if (!mapVideoFrame(videoFrame)) {
+        return nullptr;
+    }
+    auto ok = VideoScaler::boxDownscale(source, *videoFrame, factor);
+    bytes = VideoScaler::frameBytes(*videoFrame);
+    videoFrame->unmap();
+    return ok ? videoFrame : nullptr;
+}
+
+qsizetype
+VideoProvider::FrameObject::memoryBytes() const
+{
+    qsizetype bytes = ownsFrames ? frames.size() * frameFormatBytes(frameFormat) : 0;
+    for (const auto& [factor, scaled] : scaledFrames) {
+        if (!scaled.frames.empty()) {
+            bytes += scaled.frames.size()
+                     * frameFormatBytes(scaled.frames.front()->surfaceFormat());
+        }
+    }
+    return bytes;
+}
+
+void
+VideoProvider::FrameObject::reset(const QVideoFrameFormat& format, int poolSize, bool allocate)
+{
+    clear();
+    frameFormat = format;
+    ownsFrames = allocate;
+    evicted = false;
+    evictionPending = false;
+    frames.reserve(poolSize);
+    for (int i = 0; i < poolSize; ++i) {
+        frames.emplace_back(allocate ? std::make_unique<QVideoFrame>(format)
+                                     : std::make_unique<QVideoFrame>());
+    }
+}
+
+void
+VideoProvider::FrameObject::evict()
+{
+    // The format and pool size are kept to allocate the frames again
+    // once the renderer gets a subscriber.
+    auto format = frameFormat;
+    auto allocated = ownsFrames;
+    reset(format, static_cast<int>(frames.size()), false);
+    evicted = allocated;
+}
+
+void
+VideoProvider::FrameObject::clear()
+{
+    frames.clear();
+    scaledFrames.clear();
+    writeIdx = readyIdx = frontIdx = previousFrontIdx = lastWriteIdx = -1;
+    deliveryPending = false;
+}
+
 VideoProvider::VideoProvider(AVModel& avModel, QObject* parent)
+    : VideoProvider(*new AVModelVideoSource(avModel), parent)
+{
+    source_.setParent(this);
+}
+
+VideoProvider::VideoProvider(VideoSource& source, QObject* parent)
     : QObject(parent)
-    , avModel_(avModel)
+    , source_(source)
+    , framesObjects_(std::make_shared<const FrameObjectMap>())
 {
-    connect(&avModel_, &AVModel::rendererStarted, this, &VideoProvider::onRendererStarted);
-    connect(&avModel_, &AVModel::frameBufferRequested, this, &VideoProvider::onFrameBufferRequested);
-    connect(&avModel_, &AVModel::frameUpdated, this, &VideoProvider::onFrameUpdated);
-    connect(&avModel_, &AVModel::rendererStopped, this, &VideoProvider::onRendererStopped);
+    clock_.start();
+
+    connect(&source_, &VideoSource::rendererStarted, this, &VideoProvider::onRendererStarted);
+    // The frame path runs on the producer thread. Only the delivery to the
+    // sinks is posted to this object's thread, at most once per renderer.
+    connect(&source_,
+            &VideoSource::frameBufferRequested,
+            this,
+            &VideoProvider::onFrameBufferRequested,
+            Qt::DirectConnection);
+    connect(&source_,
+            &VideoSource::frameUpdated,
+            this,
+            &VideoProvider::onFrameUpdated,
+            Qt::DirectConnection);
+    connect(&source_, &VideoSource::rendererStopped, this, &VideoProvider::onRendererStopped);
 }
 
 void
-VideoProvider::registerSink(const QString& id, QVideoSink* obj)
+VideoProvider::setFramePoolSize(int size)
 {
     QMutexLocker lk(&framesObjsMutex_);
-    auto it = framesObjects_.find(id);
-    if (it == framesObjects_.end()) {
-        auto fo = std::make_unique<FrameObject>();
-        fo->subscribers.insert(obj);
-        framesObjects_.emplace(id, std::move(fo));
+    framePoolSize_ = std::clamp(size, 3, 4);
+}
+
+void
+VideoProvider::setMemoryBudget(qint64 bytes)
+{
+    QMutexLocker lk(&framesObjsMutex_);
+    memoryBudget_ = std::max<qint64>(bytes, 0);
+    enforceMemoryBudget();
+}
+
+void
+VideoProvider::setPixelFormat(const QString& format)
+{
+    QMutexLocker lk(&framesObjsMutex_);
+    if (format.compare("I420", Qt::CaseInsensitive) == 0) {
+        pixelFormat_ = QVideoFrameFormat::Format_YUV420P;
+    } else if (format.compare("NV12", Qt::CaseInsensitive) == 0) {
+        pixelFormat_ = QVideoFrameFormat::Format_NV12;
+    } else {
+        pixelFormat_ = QVideoFrameFormat::Format_RGBA8888;
+    }
+}
+
+std::shared_ptr<VideoProvider::FrameObject>
+VideoProvider::getFrameObject(const QString& id) const
+{
+    auto frameObjs = std::atomic_load(&framesObjects_);
+    auto it = frameObjs->constFind(id);
+    return it != frameObjs->cend() ? it.value() : nullptr;
+}
+
+std::shared_ptr<VideoProvider::FrameObject>
+VideoProvider::getFrameObject(QVideoSink* obj) const
+{
+    auto it = sinkRenderers_.constFind(obj);
+    return it != sinkRenderers_.cend() ? getFrameObject(it.value()) : nullptr;
+}
+
+void
+VideoProvider::insertFrameObject(const QString& id, std::shared_ptr<FrameObject> frameObj)
+{
+    auto frameObjs = *std::atomic_load(&framesObjects_);
+    frameObjs.insert(id, std::move(frameObj));
+    std::atomic_store(&framesObjects_,
+                      std::make_shared<const FrameObjectMap>(std::move(frameObjs)));
+}
+
+void
+VideoProvider::removeFrameObject(const QString& id)
+{
+    auto frameObjs = *std::atomic_load(&framesObjects_);
+    frameObjs.remove(id);
+    std::atomic_store(&framesObjects_,
+                      std::make_shared<const FrameObjectMap>(std::move(frameObjs)));
+}
+
+void
+VideoProvider::enforceMemoryBudget()
+{
+    if (memoryBudget_ == 0) {
         return;
     }
-    it->second->subscribers.insert(obj);
+    // Renderers with subscribers are never evicted, the budget may be
+    // exceeded by the visible ones alone.
+    auto frameObjs = std::atomic_load(&framesObjects_);
+    qint64 total = 0;
+    std::vector<std::pair<qint64, FrameObject*>> idle;
+    for (const auto& frameObj : *frameObjs) {
+        QMutexLocker frameLk(&frameObj->mutex);
+        auto bytes = frameObj->memoryBytes();
+        total += bytes;
+        if (bytes > 0 && frameObj->subscribers.empty() && !frameObj->evictionPending) {
+            idle.emplace_back(frameObj->lastUsedTimestamp, frameObj.get());
+        }
+    }
+    std::sort(idle.begin(), idle.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+    for (const auto& [lastUsed, frameObj] : idle) {
+        if (total <= memoryBudget_) {
+            break;
+        }
+        QMutexLocker frameLk(&frameObj->mutex);
+        total -= frameObj->memoryBytes();
+        ++evictions_;
+        // The decoder may still be writing into the back frame, it is
+        // evicted once the frame is handed back.
+        if (frameObj->writeIdx != -1) {
+            frameObj->evictionPending = true;
+            continue;
+        }
+        frameObj->evict();
+    }
 }
 
 void
-VideoProvider::unregisterSink(QVideoSink* obj)
+VideoProvider::registerSink(const QString& id, QVideoSink* obj, const QSize& size)
 {
     QMutexLocker lk(&framesObjsMutex_);
-    for (auto& frameObjIt : qAsConst(framesObjects_)) {
-        auto& subs = frameObjIt.second->subscribers;
-        auto it = subs.constFind(obj);
-        if (it != subs.cend()) {
-            subs.erase(it);
+    // Sinks destroyed without being unregistered are pruned as well.
+    connect(obj,
+            &QObject::destroyed,
+            this,
+            &VideoProvider::onSinkDestroyed,
+            Qt::UniqueConnection);
+    auto it = sinkRenderers_.find(obj);
+    if (it != sinkRenderers_.end() && it.value() != id) {
+        if (auto frameObj = getFrameObject(it.value())) {
+            QMutexLocker frameLk(&frameObj->mutex);
+            frameObj->subscribers.remove(obj);
         }
     }
+    sinkRenderers_[obj] = id;
+
+    auto frameObj = getFrameObject(id);
+    if (!frameObj) {
+        frameObj = std::make_shared<FrameObject>();
+        frameObj->subscribers.insert(obj, size);
+        frameObj->lastUsedTimestamp = clock_.nsecsElapsed();
+        insertFrameObject(id, frameObj);
+        return;
+    }
+    QMutexLocker frameLk(&frameObj->mutex);
+    frameObj->subscribers.insert(obj, size);
+    frameObj->lastUsedTimestamp = clock_.nsecsElapsed();
+    frameObj->evictionPending = false;
 }
 
-QString
-VideoProvider::captureVideoFrame(QVideoSink* obj)
+void
+VideoProvider::setSinkSize(QVideoSink* obj, const QSize& size)
 {
-    QImage img;
-    QVideoFrame currentFrame = obj->videoFrame();
-    FrameObject* frameObj {nullptr};
     QMutexLocker lk(&framesObjsMutex_);
-    for (auto& frameObjIt : qAsConst(framesObjects_)) {
-        auto& subs = frameObjIt.second->subscribers;
-        auto it = subs.constFind(obj);
-        if (it != subs.cend()) {
-            frameObj = frameObjIt.second.get();
+    auto frameObj = getFrameObject(obj);
+    if (!frameObj) {
+        return;
+    }
+    QMutexLocker frameLk(&frameObj->mutex);
+    auto it = frameObj->subscribers.find(obj);
+    if (it != frameObj->subscribers.end()) {
+        it.value() = size;
+    }
+}
+
+void
+VideoProvider::unregisterSink(QVideoSink* obj)
+{
+    QMutexLocker lk(&framesObjsMutex_);
+    disconnect(obj, &QObject::destroyed, this, &VideoProvider::onSinkDestroyed);
+    removeSink(obj);
+    enforceMemoryBudget();
+}
+
+void
+VideoProvider::onSinkDestroyed(QObject* obj)
+{
+    // Only the address is used, the sink is being destroyed.
+    QMutexLocker lk(&framesObjsMutex_);
+    removeSink(static_cast<QVideoSink*>(obj));
+    enforceMemoryBudget();
+}
+
+void
+VideoProvider::removeSink(QVideoSink* obj)
+{
+    auto it = sinkRenderers_.find(obj);
+    if (it == sinkRenderers_.end()) {
+        return;
+    }
+    auto id = it.value();
+    sinkRenderers_.erase(it);
+    auto frameObj = getFrameObject(id);
+    if (!frameObj) {
+        return;
+    }
+    QMutexLocker frameLk(&frameObj->mutex);
+    frameObj->subscribers.remove(obj);
+    frameObj->lastUsedTimestamp = clock_.nsecsElapsed();
+    // The entry of a stopped renderer, or of one that never started, is
+    // only kept for its subscribers.
+    if (frameObj->subscribers.empty() && frameObj->frames.empty()) {
+        removeFrameObject(id);
+    }
+}
+
+QVariantMap
+VideoProvider::rendererStats(const QString& id)
+{
+    auto frameObj = getFrameObject(id);
+    if (!frameObj) {
+        return {};
+    }
+    QMutexLocker frameLk(&frameObj->mutex);
+    return {{"fps", frameObj->fps},
+            {"framesDelivered", QVariant::fromValue(frameObj->framesDelivered)},
+            {"framesDropped", QVariant::fromValue(frameObj->framesDropped)},
+            {"latencyUs", frameObj->lastLatencyUs},
+            {"avgLatencyUs", frameObj->avgLatencyUs},
+            {"lastQueueDelayUs", frameObj->lastQueueDelayUs},
+            {"maxQueueDelayUs", frameObj->maxQueueDelayUs},
+            {"bytesCopied", QVariant::fromValue(frameObj->bytesCopied)},
+            {"bytesSaved", QVariant::fromValue(frameObj->bytesSaved)},
+            {"scaledSizes", static_cast<int>(frameObj->scaledFrames.size())},
+            {"subscribers", static_cast<int>(frameObj->subscribers.size())},
+            {"memoryBytes", static_cast<qint64>(frameObj->memoryBytes())}};
+}
+
+QVariantMap
+VideoProvider::memoryStats()
+{
+    QMutexLocker lk(&framesObjsMutex_);
+    auto frameObjs = std::atomic_load(&framesObjects_);
+    qint64 bytes = 0;
+    int idle = 0;
+    for (const auto& frameObj : *frameObjs) {
+        QMutexLocker frameLk(&frameObj->mutex);
+        bytes += frameObj->memoryBytes();
+        if (frameObj->subscribers.empty()) {
+            ++idle;
         }
     }
-    if (frameObj) {
-        QMutexLocker lk(&frameObj->mutex);
-        auto imageFormat = QVideoFrameFormat::imageFormatFromPixelFormat(
-            QVideoFrameFormat::Format_RGBA8888);
-        img = QImage(currentFrame.bits(0),
-                     currentFrame.width(),
-                     currentFrame.height(),
-                     currentFrame.bytesPerLine(0),
-                     imageFormat);
+    return {{"bytes", bytes},
+            {"budget", memoryBudget_},
+            {"renderers", static_cast<int>(frameObjs->size())},
+            {"idleRenderers", idle},
+            {"evictions", QVariant::fromValue(evictions_)}};
+}
+
+void
+VideoProvider::logRendererStats()
+{
+    auto frameObjs = std::atomic_load(&framesObjects_);
+    for (auto it = frameObjs->cbegin(); it != frameObjs->cend(); ++it) {
+        auto stats = rendererStats(it.key());
+        qInfo().noquote() << "Renderer" << it.key() << "fps:" << stats["fps"].toDouble()
+                          << "delivered:" << stats["framesDelivered"].toULongLong()
+                          << "dropped:" << stats["framesDropped"].toULongLong()
+                          << "latency(us):" << stats["latencyUs"].toLongLong() << "avg"
+                          << stats["avgLatencyUs"].toLongLong()
+                          << "queue delay(us):" << stats["lastQueueDelayUs"].toLongLong() << "max"
+                          << stats["maxQueueDelayUs"].toLongLong()
+                          << "copied:" << stats["bytesCopied"].toULongLong()
+                          << "saved:" << stats["bytesSaved"].toULongLong()
+                          << "subscribers:" << stats["subscribers"].toInt()
+                          << "memory:" << stats["memoryBytes"].toLongLong();
+    }
+    auto memory = memoryStats();
+    qInfo().noquote() << "Video buffers:" << memory["bytes"].toLongLong() << "bytes, budget"
+                      << memory["budget"].toLongLong() << "renderers:"
+                      << memory["renderers"].toInt() << "idle:" << memory["idleRenderers"].toInt()
+                      << "evictions:" << memory["evictions"].toULongLong();
+}
+
+QVideoFrame
+VideoProvider::grabVideoFrame(QVideoSink* obj)
+{
+    QMutexLocker lk(&framesObjsMutex_);
+    auto frameObj = getFrameObject(obj);
+    lk.unlock();
+    if (!frameObj) {
+        return {};
     }
-    return Utils::byteArrayToBase64String(Utils::QImageToByteArray(img));
+    QMutexLocker frameLk(&frameObj->mutex);
+    // Use the full resolution frame rather than the one held by the
+    // sink, which may be a downscaled copy. Only a reference is taken
+    // under the lock, the callers convert it.
+    if (frameObj->frontIdx == -1) {
+        return {};
+    }
+    return *frameObj->frames.at(frameObj->frontIdx);
+}
+
+QString
+VideoProvider::captureVideoFrame(QVideoSink* obj)
+{
+    // toImage also handles the color conversion of planar formats.
+    return Utils::byteArrayToBase64String(
+        Utils::QImageToByteArray(grabVideoFrame(obj).toImage()));
+}
+
+int
+VideoProvider::captureVideoFrameAsync(QVideoSink* obj, const QString& format, int quality)
+{
+    auto requestId = ++captureRequestId_;
+    // Only a reference to the frame is taken on the calling thread, the
+    // color conversion and the encoding are left to the thread pool.
+    auto frame = grabVideoFrame(obj);
+    std::ignore = QtConcurrent::run([this, requestId, frame, format, quality] {
+        auto img = frame.isValid() ? frame.toImage() : QImage();
+        auto data = img.isNull()
+                        ? QString()
+                        : Utils::byteArrayToBase64String(
+                            Utils::QImageToByteArray(img, format.toLatin1().constData(), quality));
+        Q_EMIT videoFrameCaptured(requestId, data);
+    });
+    return requestId;
 }
 
 void
 VideoProvider::onRendererStarted(const QString& id)
 {
-    auto size = avModel_.getRendererSize(id);
+    auto size = source_.getRendererSize(id);
     // This slot is queued, the renderer may have been destroyed.
     if (size.width() == 0 || size.height() == 0) {
         return;
     }
-    auto pixelFormat = avModel_.useDirectRenderer() ? QVideoFrameFormat::Format_RGBA8888
-                                                    : QVideoFrameFormat::Format_BGRA8888;
-    auto frameFormat = QVideoFrameFormat(size, pixelFormat);
     {
         QMutexLocker lk(&framesObjsMutex_);
-        auto it = framesObjects_.find(id);
-        if (it == framesObjects_.end()) {
-            auto fo = std::make_unique<FrameObject>();
-            fo->videoFrame = std::make_unique<QVideoFrame>(frameFormat);
-            framesObjects_.emplace(id, std::move(fo));
+        // The shared memory renderer always produces BGRA, only the direct
+        // renderer can let jamid write the decoded planar layout.
+        auto pixelFormat = source_.useDirectRenderer() ? pixelFormat_
+                                                       : QVideoFrameFormat::Format_BGRA8888;
+        auto frameFormat = QVideoFrameFormat(size, pixelFormat);
+        auto frameObj = getFrameObject(id);
+        if (!frameObj) {
+            frameObj = std::make_shared<FrameObject>();
+            frameObj->reset(frameFormat, framePoolSize_, true);
+            frameObj->lastUsedTimestamp = clock_.nsecsElapsed();
+            insertFrameObject(id, frameObj);
         } else {
-            it->second->videoFrame.reset(new QVideoFrame(frameFormat));
+            QMutexLocker frameLk(&frameObj->mutex);
+            frameObj->reset(frameFormat, framePoolSize_, true);
+            frameObj->lastUsedTimestamp = clock_.nsecsElapsed();
         }
+        enforceMemoryBudget();
     }
 
     activeRenderers_[id] = size;
@@ -124,85 +571,190 @@ VideoProvider::onRendererStarted(const QString& id)
 void
 VideoProvider::onFrameBufferRequested(const QString& id, AVFrame* avframe)
 {
-    QMutexLocker framesLk(&framesObjsMutex_);
-    auto it = framesObjects_.find(id);
-    if (it == framesObjects_.end()) {
+    auto frameObj = getFrameObject(id);
+    if (!frameObj) {
         return;
     }
-    if (it->second->subscribers.empty()) {
+    QMutexLocker lk(&frameObj->mutex);
+    if (frameObj->subscribers.empty()) {
         return;
     }
-    QMutexLocker lk(&it->second->mutex);
-    auto videoFrame = it->second->videoFrame.get();
+    if (frameObj->evicted) {
+        auto format = frameObj->frameFormat;
+        frameObj->reset(format, static_cast<int>(frameObj->frames.size()), true);
+    }
+    auto videoFrame = frameObj->acquireBackFrame();
     if (!mapVideoFrame(videoFrame)) {
         qWarning() << "QVideoFrame can't be mapped" << id;
         return;
     }
+    frameObj->requestTimestamp = clock_.nsecsElapsed();
     // The ownership of avframe structure remains the subscriber(jamid), and
     // the videoFrame instance is owned by the VideoProvider(client). The
     // avframe structure contains only a description of the QVideoFrame
-    // underlying buffer.
-    // TODO: ideally, the colorspace format should likely come from jamid and
-    // be the decoded format.
-    avframe->format = AV_PIX_FMT_RGBA;
+    // underlying buffer. For planar YUV formats, jamid keeps the decoded
+    // layout and the color conversion is left to the RHI shaders.
+    avframe->format = toAVPixelFormat(videoFrame->pixelFormat());
     avframe->width = videoFrame->width();
     avframe->height = videoFrame->height();
-    avframe->data[0] = (uint8_t*) videoFrame->bits(0);
-    avframe->linesize[0] = videoFrame->bytesPerLine(0);
+    for (int plane = 0; plane < videoFrame->planeCount(); ++plane) {
+        avframe->data[plane] = (uint8_t*) videoFrame->bits(plane);
+        avframe->linesize[plane] = videoFrame->bytesPerLine(plane);
+    }
 }
 
 void
 VideoProvider::onFrameUpdated(const QString& id)
 {
-    QMutexLocker framesLk(&framesObjsMutex_);
-    auto it = framesObjects_.find(id);
-    if (it == framesObjects_.end()) {
+    auto frameObj = getFrameObject(id);
+    if (!frameObj) {
         return;
     }
-    if (it->second->subscribers.empty()) {
+    QMutexLocker lk(&frameObj->mutex);
+    if (frameObj->subscribers.empty()) {
+        // The back frame is not published, the decoder is done with it.
+        frameObj->writeIdx = -1;
+        if (frameObj->evictionPending) {
+            frameObj->evict();
+        }
         return;
     }
-    QMutexLocker lk(&it->second->mutex);
-    auto videoFrame = it->second->videoFrame.get();
-    if (videoFrame == nullptr) {
+    if (frameObj->frames.empty()) {
         qWarning() << "QVideoFrame has not been initialized.";
         return;
     }
-    if (!avModel_.useDirectRenderer()) {
-        // Shared memory renderering.
+    if (!source_.useDirectRenderer()) {
+        // Shared memory renderering: the daemon reuses its buffer once
+        // this returns, the frame is copied into the back frame.
+        if (frameObj->evicted) {
+            auto format = frameObj->frameFormat;
+            frameObj->reset(format, static_cast<int>(frameObj->frames.size()), true);
+        }
+        auto videoFrame = frameObj->acquireBackFrame();
         if (!mapVideoFrame(videoFrame)) {
             qWarning() << "QVideoFrame can't be mapped" << id;
             return;
         }
-        auto frame = avModel_.getRendererFrame(id);
-        std::memcpy(videoFrame->bits(0), frame.ptr, frame.size);
+        frameObj->requestTimestamp = clock_.nsecsElapsed();
+        auto frame = source_.getRendererFrame(id);
+        auto size = std::min<qsizetype>(frame.size, videoFrame->mappedBytes(0));
+        if (!frame.ptr || size <= 0) {
+            return;
+        }
+        std::memcpy(videoFrame->bits(0), frame.ptr, size);
+        frameObj->bytesCopied += size;
+    }
+    if (!frameObj->publishBackFrame(clock_.nsecsElapsed()) || frameObj->deliveryPending) {
+        return;
+    }
+    // Mailbox: a single delivery is queued per renderer, frames published
+    // in the meantime replace the ready one instead of queuing up.
+    frameObj->deliveryPending = true;
+    QMetaObject::invokeMethod(
+        this, [this, id] { deliverFrame(id); }, Qt::QueuedConnection);
+}
+
+void
+VideoProvider::deliverFrame(const QString& id)
+{
+    auto frameObj = getFrameObject(id);
+    if (!frameObj) {
+        return;
+    }
+    QMutexLocker lk(&frameObj->mutex);
+    frameObj->deliveryPending = false;
+    auto readyTimestamp = frameObj->readyTimestamp;
+    auto requestTimestamp = frameObj->readyRequestTimestamp;
+    auto videoFrame = frameObj->takeReadyFrame();
+    if (!videoFrame || !videoFrame->isMapped()) {
+        return;
+    }
+    frameObj->lastQueueDelayUs = (clock_.nsecsElapsed() - readyTimestamp) / 1000;
+    frameObj->maxQueueDelayUs = std::max(frameObj->maxQueueDelayUs, frameObj->lastQueueDelayUs);
+
+    // The downscaling and the delivery run without the lock, which the
+    // producer thread needs for every frame. The presented frame is not
+    // recycled before the next delivery, on this thread, and the local
+    // copy keeps its buffer alive should the renderer be reset.
+    auto frame = *videoFrame;
+    auto frontIdx = frameObj->frontIdx;
+    auto poolSize = static_cast<int>(frameObj->frames.size());
+    auto subscribers = frameObj->subscribers;
+    auto scaledFrames = std::move(frameObj->scaledFrames);
+    frameObj->scaledFrames.clear();
+    lk.unlock();
+
+    // Small sinks get a downscaled copy, built once per distinct box
+    // factor while the full frame is still mapped.
+    std::map<int, QVideoFrame*> scaled;
+    for (auto subIt = subscribers.cbegin(); subIt != subscribers.cend(); ++subIt) {
+        auto factor = VideoScaler::downscaleFactor(frame.size(), subIt.value());
+        if (factor > 1 && scaled.find(factor) == scaled.end()) {
+            scaled[factor] = scaledFrames[factor].scale(frame, factor, poolSize);
+        }
     }
-    if (videoFrame->isMapped()) {
-        videoFrame->unmap();
-        for (const auto& sink : qAsConst(it->second->subscribers)) {
-            sink->setVideoFrame(*videoFrame);
-            Q_EMIT sink->videoFrameChanged(*videoFrame);
+    for (auto scaledIt = scaledFrames.begin(); scaledIt != scaledFrames.end();) {
+        if (scaled.find(scaledIt->first) == scaled.end()) {
+            scaledIt = scaledFrames.erase(scaledIt);
+        } else {
+            ++scaledIt;
         }
     }
+    auto fullBytes = VideoScaler::frameBytes(frame);
+    frame.unmap();
+
+    quint64 bytesSaved = 0;
+    for (auto subIt = subscribers.cbegin(); subIt != subscribers.cend(); ++subIt) {
+        auto sink = subIt.key();
+        auto factor = VideoScaler::downscaleFactor(frame.size(), subIt.value());
+        auto scaledIt = scaled.find(factor);
+        auto sinkFrame = &frame;
+        if (scaledIt != scaled.end() && scaledIt->second) {
+            sinkFrame = scaledIt->second;
+            bytesSaved += fullBytes - scaledFrames[factor].bytes;
+        }
+        sink->setVideoFrame(*sinkFrame);
+        Q_EMIT sink->videoFrameChanged(*sinkFrame);
+    }
+
+    lk.relock();
+    // The scaled frames are dropped if the renderer was reset meanwhile.
+    if (frameObj->frontIdx == frontIdx) {
+        frameObj->scaledFrames = std::move(scaledFrames);
+    }
+    frameObj->bytesSaved += bytesSaved;
+    auto now = clock_.nsecsElapsed();
+    frameObj->lastUsedTimestamp = now;
+    frameObj->lastLatencyUs = (now - requestTimestamp) / 1000;
+    frameObj->avgLatencyUs = frameObj->framesDelivered == 0
+                                 ? frameObj->lastLatencyUs
+                                 : (frameObj->avgLatencyUs * 7 + frameObj->lastLatencyUs) / 8;
+    ++frameObj->framesDelivered;
+    ++frameObj->fpsWindowFrames;
+    auto fpsWindow = now - frameObj->fpsWindowStart;
+    if (fpsWindow >= 1000000000) {
+        frameObj->fps = frameObj->fpsWindowFrames * 1e9 / fpsWindow;
+        frameObj->fpsWindowFrames = 0;
+        frameObj->fpsWindowStart = now;
+    }
 }
 
 void
 VideoProvider::onRendererStopped(const QString& id)
 {
     QMutexLocker framesLk(&framesObjsMutex_);
-    auto it = framesObjects_.find(id);
-    if (it == framesObjects_.end()) {
+    auto frameObj = getFrameObject(id);
+    if (!frameObj) {
         return;
     }
 
     activeRenderers_.remove(id);
     Q_EMIT activeRenderersChanged();
 
-    QMutexLocker lk(&it->second->mutex);
-    if (it->second->subscribers.empty()) {
-        lk.unlock();
-        framesObjects_.erase(it);
+    QMutexLocker lk(&frameObj->mutex);
+    if (frameObj->subscribers.empty()) {
+        removeFrameObject(id);
         return;
     }
-    it->second->videoFrame.reset();
+    frameObj->clear();
 }
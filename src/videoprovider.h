@@ -20,17 +20,16 @@
 
 #include "utils.h"
 #include "qtutils.h"
-
-#include "api/avmodel.h"
-
-extern "C" {
-#include "libavutil/frame.h"
-}
+#include "videosource.h"
 
 #include <QVideoSink>
 #include <QVideoFrame>
 #include <QQmlEngine>
 #include <QMutex>
+#include <QElapsedTimer>
+
+#include <atomic>
+#include <memory>
 
 using namespace lrc::api;
 
@@ -41,27 +40,153 @@ class VideoProvider final : public QObject
     QML_PROPERTY(QVariantMap, activeRenderers)
 public:
     explicit VideoProvider(AVModel& avModel, QObject* parent = nullptr);
+    explicit VideoProvider(VideoSource& source, QObject* parent = nullptr);
     ~VideoProvider() = default;
 
-    Q_INVOKABLE void registerSink(const QString& id, QVideoSink* obj);
+    // size is the on-screen pixel size of the sink, when known, and is
+    // used to deliver downscaled frames to small sinks.
+    Q_INVOKABLE void registerSink(const QString& id, QVideoSink* obj, const QSize& size = {});
+    Q_INVOKABLE void setSinkSize(QVideoSink* obj, const QSize& size);
     Q_INVOKABLE void unregisterSink(QVideoSink* obj);
+    // Pipeline statistics of a renderer: delivered fps, delivered and
+    // dropped frames, latency from buffer request to sink delivery,
+    // queueing delay, bytes copied from shared memory, bytes saved by
+    // downscaling, subscriber count and buffer memory.
+    Q_INVOKABLE QVariantMap rendererStats(const QString& id);
+    // Video buffer footprint: bytes held by every renderer, memory
+    // budget, renderer and idle renderer counts, and evictions so far.
+    Q_INVOKABLE QVariantMap memoryStats();
+    // Dump the statistics of every renderer to the log.
+    Q_INVOKABLE void logRendererStats();
     Q_INVOKABLE QString captureVideoFrame(QVideoSink* obj);
+    // Encodes the current frame of the sink on the thread pool, using an
+    // image format supported by QImageWriter ("PNG", "JPEG", ...). The
+    // returned request id is passed back with videoFrameCaptured.
+    Q_INVOKABLE int captureVideoFrameAsync(QVideoSink* obj,
+                                           const QString& format = "PNG",
+                                           int quality = -1);
+
+    // Number of frames allocated per renderer, clamped to [3, 4].
+    // Only applies to renderers started after the call.
+    void setFramePoolSize(int size);
+
+    // Pixel format requested from the direct renderer: "RGBA" (default),
+    // "I420" or "NV12". Only applies to renderers started after the call.
+    void setPixelFormat(const QString& format);
+
+    // Soft limit, in bytes, of the frames held by all renderers. When it
+    // is exceeded, the frames of renderers without subscribers are
+    // released, least recently used first. 0 disables the limit.
+    void setMemoryBudget(qint64 bytes);
+
+Q_SIGNALS:
+    // data is the base64 encoded image, empty if no frame was available.
+    void videoFrameCaptured(int requestId, const QString& data);
 
 private Q_SLOTS:
     void onRendererStarted(const QString& id);
     void onFrameBufferRequested(const QString& id, AVFrame* avframe);
     void onFrameUpdated(const QString& id);
     void onRendererStopped(const QString& id);
+    void onSinkDestroyed(QObject* obj);
 
 private:
-    AVModel& avModel_;
+    void deliverFrame(const QString& id);
+    QVideoFrame grabVideoFrame(QVideoSink* obj);
+    void removeSink(QVideoSink* obj);
+    void enforceMemoryBudget();
+
+    VideoSource& source_;
+    QElapsedTimer clock_;
 
+    // Downscaled copies of the presented frame, shared by every sink
+    // needing the same box factor and recycled round-robin.
+    struct ScaledFrames
+    {
+        std::vector<std::unique_ptr<QVideoFrame>> frames;
+        int index {-1};
+        qsizetype bytes {0};
+
+        // Downscales source into the next frame of a pool of poolSize.
+        QVideoFrame* scale(const QVideoFrame& source, int factor, int poolSize);
+    };
+
+    // Each renderer owns a small pool of frames so that the decoder
+    // always writes into a back buffer while the sinks hold the most
+    // recent complete frame. A slot is only recycled once it is neither
+    // presented (front), presented before it, as the render thread may
+    // still be uploading it, nor waiting to be presented (ready).
     struct FrameObject
     {
-        std::unique_ptr<QVideoFrame> videoFrame;
+        QVideoFrameFormat frameFormat;
+        std::vector<std::unique_ptr<QVideoFrame>> frames;
+        int writeIdx {-1};
+        int readyIdx {-1};
+        int frontIdx {-1};
+        int previousFrontIdx {-1};
+        int lastWriteIdx {-1};
+        std::map<int, ScaledFrames> scaledFrames;
+        bool deliveryPending {false};
+        // The frames are allocated, they are not after an eviction.
+        bool ownsFrames {false};
+        // The frames were released by the memory budget, they are
+        // allocated again on the next buffer request.
+        bool evicted {false};
+        // Evicted while the decoder was writing into the back frame, the
+        // frames are released once it is handed back.
+        bool evictionPending {false};
+        // Timestamp (ns) of the last delivery or subscription change,
+        // orders the eviction of idle renderers.
+        qint64 lastUsedTimestamp {0};
+        // Timestamps (ns) of the last buffer request and, for the ready
+        // frame, of its request and of its publication.
+        qint64 requestTimestamp {0};
+        qint64 readyRequestTimestamp {0};
+        qint64 readyTimestamp {0};
+        // Statistics, see rendererStats.
+        quint64 framesDelivered {0};
+        quint64 framesDropped {0};
+        qint64 fpsWindowStart {0};
+        int fpsWindowFrames {0};
+        double fps {0.};
+        qint64 lastLatencyUs {0};
+        qint64 avgLatencyUs {0};
+        qint64 lastQueueDelayUs {0};
+        qint64 maxQueueDelayUs {0};
+        quint64 bytesCopied {0};
+        quint64 bytesSaved {0};
         QMutex mutex;
-        QSet<QVideoSink*> subscribers;
+        // Subscribed sinks and their on-screen pixel size.
+        QHash<QVideoSink*, QSize> subscribers;
+
+        QVideoFrame* acquireBackFrame();
+        bool publishBackFrame(qint64 timestamp);
+        QVideoFrame* takeReadyFrame();
+        qsizetype memoryBytes() const;
+        void reset(const QVideoFrameFormat& format, int poolSize, bool allocate);
+        void evict();
+        void clear();
     };
-    std::map<QString, std::unique_ptr<FrameObject>> framesObjects_;
+    // The renderer registry is read-mostly: the frame path only loads the
+    // current snapshot, while writers, serialized by framesObjsMutex_,
+    // publish a modified copy. Frame objects are shared so that a reader
+    // holding an old snapshot keeps them alive.
+    using FrameObjectMap = QHash<QString, std::shared_ptr<FrameObject>>;
+    std::shared_ptr<const FrameObjectMap> framesObjects_;
     QMutex framesObjsMutex_;
+    // Reverse index of the renderer id each sink is subscribed to,
+    // guarded by framesObjsMutex_.
+    QHash<QVideoSink*, QString> sinkRenderers_;
+
+    std::shared_ptr<FrameObject> getFrameObject(const QString& id) const;
+    std::shared_ptr<FrameObject> getFrameObject(QVideoSink* obj) const;
+    void insertFrameObject(const QString& id, std::shared_ptr<FrameObject> frameObj);
+    void removeFrameObject(const QString& id);
+
+    int framePoolSize_ {3};
+    // Guarded by framesObjsMutex_.
+    qint64 memoryBudget_ {0};
+    quint64 evictions_ {0};
+    std::atomic<int> captureRequestId_ {0};
+    QVideoFrameFormat::PixelFormat pixelFormat_ {QVideoFrameFormat::Format_RGBA8888};
 };
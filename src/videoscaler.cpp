@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2022 Savoir-faire Linux Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "videoscaler.h"
+
+#include <algorithm>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VIDEOSCALER_SSE2
+#endif
+
+namespace {
+
+struct PlaneLayout
+{
+    int width {0};
+    int height {0};
+    int bytesPerPixel {0};
+};
+
+PlaneLayout
+planeLayout(const QVideoFrame& frame, int plane)
+{
+    const auto w = frame.width();
+    const auto h = frame.height();
+    switch (frame.pixelFormat()) {
+    case QVideoFrameFormat::Format_YUV420P:
+        if (plane == 0)
+            return {w, h, 1};
+        return {(w + 1) / 2, (h + 1) / 2, 1};
+    case QVideoFrameFormat::Format_NV12:
+        if (plane == 0)
+            return {w, h, 1};
+        return {(w + 1) / 2, (h + 1) / 2, 2};
+    case QVideoFrameFormat::Format_RGBA8888:
+    case QVideoFrameFormat::Format_BGRA8888:
+        return {w, h, 4};
+    default:
+        return {};
+    }
+}
+
+// Adds `count` bytes of a source row into 16-bit accumulators.
+void
+accumulateRow(const uchar* src, quint16* acc, int count)
+{
+    int i = 0;
+#ifdef VIDEOSCALER_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i + 8));
+        lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(bytes, zero));
+        hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(bytes, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + i), lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(acc + i + 8), hi);
+    }
+#endif
+    for (; i < count; ++i)
+        acc[i] += src[i];
+}
+
+void
+downscalePlane(const uchar* src,
+               int srcStride,
+               uchar* dst,
+               int dstStride,
+               const PlaneLayout& dstLayout,
+               int factor)
+{
+    const auto bpp = dstLayout.bytesPerPixel;
+    const auto rowBytes = dstLayout.width * factor * bpp;
+    const auto area = static_cast<quint32>(factor * factor);
+    std::vector<quint16> acc(rowBytes);
+
+    for (int y = 0; y < dstLayout.height; ++y) {
+        // Vertical pass: sum `factor` source rows.
+        std::fill(acc.begin(), acc.end(), 0);
+        const uchar* srcRow = src + static_cast<qsizetype>(y) * factor * srcStride;
+        for (int r = 0; r < factor; ++r, srcRow += srcStride)
+            accumulateRow(srcRow, acc.data(), rowBytes);
+
+        // Horizontal pass: sum `factor` adjacent samples per channel.
+        uchar* dstRow = dst + static_cast<qsizetype>(y) * dstStride;
+        for (int x = 0; x < dstLayout.width; ++x) {
+            const quint16* block = acc.data() + x * factor * bpp;
+            for (int c = 0; c < bpp; ++c) {
+                quint32 sum = 0;
+                for (int k = 0; k < factor; ++k)
+                    sum += block[k * bpp + c];
+                dstRow[x * bpp + c] = static_cast<uchar>((sum + area / 2) / area);
+            }
+        }
+    }
+}
+
+} // namespace
+
+int
+VideoScaler::downscaleFactor(const QSize& source, const QSize& target)
+{
+    if (!source.isValid() || !target.isValid() || target.isEmpty())
+        return 1;
+    auto factor = std::min(source.width() / target.width(), source.height() / target.height());
+    return std::clamp(factor, 1, kMaxFactor);
+}
+
+QSize
+VideoScaler::scaledSize(const QSize& source, int factor)
+{
+    return QSize((source.width() / factor) & ~1, (source.height() / factor) & ~1);
+}
+
+qsizetype
+VideoScaler::frameBytes(const QVideoFrame& frame)
+{
+    qsizetype bytes = 0;
+    for (int plane = 0; plane < frame.planeCount(); ++plane) {
+        bytes += static_cast<qsizetype>(frame.bytesPerLine(plane))
+                 * planeLayout(frame, plane).height;
+    }
+    return bytes;
+}
+
+bool
+VideoScaler::boxDownscale(const QVideoFrame& src, QVideoFrame& dst, int factor)
+{
+    if (factor < 2 || factor > kMaxFactor || !src.isMapped() || !dst.isMapped()
+        || src.pixelFormat() != dst.pixelFormat() || src.planeCount() != dst.planeCount()
+        || dst.size() != scaledSize(src.size(), factor)) {
+        return false;
+    }
+    for (int plane = 0; plane < dst.planeCount(); ++plane) {
+        auto layout = planeLayout(dst, plane);
+        if (layout.bytesPerPixel == 0)
+            return false;
+        downscalePlane(src.bits(plane),
+                       src.bytesPerLine(plane),
+                       dst.bits(plane),
+                       dst.bytesPerLine(plane),
+                       layout,
+                       factor);
+    }
+    return true;
+}
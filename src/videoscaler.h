@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2022 Savoir-faire Linux Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QSize>
+#include <QVideoFrame>
+
+namespace VideoScaler {
+
+// Largest integer box factor that still covers the target size in both
+// dimensions, capped to kMaxFactor. Returns 1 when no downscale applies.
+constexpr static int kMaxFactor = 16;
+int downscaleFactor(const QSize& source, const QSize& target);
+
+// Size of a frame downscaled by factor, kept even for chroma subsampling.
+QSize scaledSize(const QSize& source, int factor);
+
+// Number of bytes covered by the planes of a mapped frame.
+qsizetype frameBytes(const QVideoFrame& frame);
+
+// Box-filters every plane of the mapped frame src into the mapped frame
+// dst. Both frames must share the same pixel format, and dst must have
+// the size returned by scaledSize(src.size(), factor).
+bool boxDownscale(const QVideoFrame& src, QVideoFrame& dst, int factor);
+
+} // namespace VideoScaler
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2022 Savoir-faire Linux Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "api/avmodel.h"
+
+extern "C" {
+#include "libavutil/frame.h"
+}
+
+#include <QObject>
+#include <QSize>
+
+// The renderer events and queries VideoProvider relies on. The
+// application forwards them from AVModel, the video benchmark
+// provides a synthetic implementation.
+class VideoSource : public QObject
+{
+    Q_OBJECT
+public:
+    explicit VideoSource(QObject* parent = nullptr)
+        : QObject(parent)
+    {}
+    virtual ~VideoSource() = default;
+
+    virtual QSize getRendererSize(const QString& id) = 0;
+    virtual bool useDirectRenderer() const = 0;
+    virtual lrc::api::video::Frame getRendererFrame(const QString& id) = 0;
+
+Q_SIGNALS:
+    void rendererStarted(const QString& id);
+    void frameBufferRequested(const QString& id, AVFrame* frame);
+    void frameUpdated(const QString& id);
+    void rendererStopped(const QString& id);
+};
+
+class AVModelVideoSource final : public VideoSource
+{
+    Q_OBJECT
+public:
+    explicit AVModelVideoSource(lrc::api::AVModel& avModel, QObject* parent = nullptr)
+        : VideoSource(parent)
+        , avModel_(avModel)
+    {
+        using lrc::api::AVModel;
+        connect(&avModel_, &AVModel::rendererStarted, this, &VideoSource::rendererStarted);
+        connect(&avModel_,
+                &AVModel::frameBufferRequested,
+                this,
+                &VideoSource::frameBufferRequested,
+                Qt::DirectConnection);
+        connect(&avModel_,
+                &AVModel::frameUpdated,
+                this,
+                &VideoSource::frameUpdated,
+                Qt::DirectConnection);
+        connect(&avModel_, &AVModel::rendererStopped, this, &VideoSource::rendererStopped);
+    }
+
+    QSize getRendererSize(const QString& id) override
+    {
+        return avModel_.getRendererSize(id);
+    }
+    bool useDirectRenderer() const override
+    {
+        return avModel_.useDirectRenderer();
+    }
+    lrc::api::video::Frame getRendererFrame(const QString& id) override
+    {
+        return avModel_.getRendererFrame(id);
+    }
+
+private:
+    lrc::api::AVModel& avModel_;
+};
@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2022 Savoir-faire Linux Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Avatar decode benchmark.
+ *
+ * Decodes a synthetic profile picture the way Utils::avatarFromBase64String
+ * does (decode, circle crop, scale to the requested size), once with a full
+ * size decode and once decoding downscaled to the requested size, and
+ * reports the time and the peak resident memory of each.
+ *
+ * The peak is read from VmHWM, reset through /proc/self/clear_refs before
+ * each run, so it is only available on Linux.
+ *
+ * Example:
+ *   avatardecode_benchmark --resolution 4000x3000 --sizes 24,48,100 --iterations 20
+ */
+
+#include "utils.h"
+
+#include <QBuffer>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QGuiApplication>
+
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+// Gradient with noise, so that the encoder cannot compress it away.
+QByteArray
+encodeSyntheticImage(const QSize& size, const char* format)
+{
+    QImage image(size, QImage::Format_RGB32);
+    quint32 seed = 1;
+    for (int y = 0; y < size.height(); ++y) {
+        auto* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < size.width(); ++x) {
+            seed = seed * 1664525u + 1013904223u;
+            auto noise = static_cast<int>(seed >> 28);
+            line[x] = qRgb((x * 255 / size.width() + noise) & 0xff,
+                           (y * 255 / size.height() + noise) & 0xff,
+                           (128 + noise) & 0xff);
+        }
+    }
+    return Utils::QImageToByteArray(image, format, 90);
+}
+
+// Peak resident set size in KiB since the last reset, -1 if unknown.
+qint64
+peakResidentKb()
+{
+    QFile status("/proc/self/status");
+    if (!status.open(QIODevice::ReadOnly))
+        return -1;
+    for (const auto& line : status.readAll().split('\n')) {
+        if (line.startsWith("VmHWM:"))
+            return line.mid(6).trimmed().split(' ').first().toLongLong();
+    }
+    return -1;
+}
+
+qint64
+residentKb()
+{
+    QFile status("/proc/self/status");
+    if (!status.open(QIODevice::ReadOnly))
+        return -1;
+    for (const auto& line : status.readAll().split('\n')) {
+        if (line.startsWith("VmRSS:"))
+            return line.mid(6).trimmed().split(' ').first().toLongLong();
+    }
+    return -1;
+}
+
+void
+resetPeakResident()
+{
+    QFile clearRefs("/proc/self/clear_refs");
+    if (clearRefs.open(QIODevice::WriteOnly))
+        clearRefs.write("5");
+}
+
+struct Result
+{
+    double msPerDecode {0.};
+    qint64 peakKb {-1};
+    QSize decoded;
+};
+
+Result
+run(int iterations, const std::function<QImage()>& decode)
+{
+    Result result;
+    resetPeakResident();
+    auto baseline = residentKb();
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i)
+        result.decoded = decode().size();
+    result.msPerDecode = timer.nsecsElapsed() / 1e6 / iterations;
+
+    auto peak = peakResidentKb();
+    if (peak >= 0 && baseline >= 0)
+        result.peakKb = std::max<qint64>(0, peak - baseline);
+    return result;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Avatar decode benchmark");
+    parser.addHelpOption();
+    QCommandLineOption resolutionOption("resolution",
+                                        "Source picture size (WxH).",
+                                        "size",
+                                        "4000x3000");
+    QCommandLineOption sizesOption("sizes",
+                                   "Comma separated requested avatar sizes.",
+                                   "sizes",
+                                   "24,48,100");
+    QCommandLineOption formatOption("format", "Source picture format.", "format", "JPEG");
+    QCommandLineOption iterationsOption("iterations", "Decodes per run.", "count", "20");
+    parser.addOptions({resolutionOption, sizesOption, formatOption, iterationsOption});
+    parser.process(app);
+
+    auto parts = parser.value(resolutionOption).split('x');
+    QSize resolution = parts.size() == 2 ? QSize(parts[0].toInt(), parts[1].toInt()) : QSize();
+    if (resolution.isEmpty()) {
+        qCritical() << "Invalid resolution" << parser.value(resolutionOption);
+        return 1;
+    }
+    auto format = parser.value(formatOption).toLatin1();
+    auto iterations = std::max(1, parser.value(iterationsOption).toInt());
+
+    auto data = encodeSyntheticImage(resolution, format.constData());
+    if (data.isEmpty()) {
+        qCritical() << "Cannot encode" << format;
+        return 1;
+    }
+    printf("source %dx%d %s, %lld bytes, %d decode(s) per run\n",
+           resolution.width(),
+           resolution.height(),
+           format.constData(),
+           static_cast<long long>(data.size()),
+           iterations);
+
+    for (const auto& value : parser.value(sizesOption).split(',')) {
+        auto side = value.toInt();
+        if (side <= 0)
+            continue;
+        QSize size(side, side);
+
+        auto full = run(iterations, [&] {
+            return Utils::scaleAndFrame(Utils::imageFromBase64Data(data, true), size);
+        });
+        auto scaled = run(iterations, [&] {
+            return Utils::scaleAndFrame(Utils::imageFromBase64Data(data, true, size), size);
+        });
+
+        printf("size %3d  full decode: %8.2f ms, peak %7lld KiB  "
+               "scaled decode: %8.2f ms, peak %7lld KiB\n",
+               side,
+               full.msPerDecode,
+               static_cast<long long>(full.peakKb),
+               scaled.msPerDecode,
+               static_cast<long long>(scaled.peakKb));
+    }
+
+    return 0;
+}
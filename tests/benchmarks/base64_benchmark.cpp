@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2022 Savoir-faire Linux Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Base64 codec microbenchmark.
+ *
+ * Compares the round trips avatar data used to go through, QString to
+ * Latin-1 to QByteArray::fromBase64 and back through toBase64 and
+ * QString::fromLatin1, with the Base64 codec working on the QString
+ * directly, for payloads of 10 KB to 5 MB.
+ *
+ * Example:
+ *   base64_benchmark --sizes 10K,100K,1M,5M --iterations 50
+ */
+
+#include "base64.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+qsizetype
+parseSize(QString value)
+{
+    qsizetype unit = 1;
+    if (value.endsWith('K', Qt::CaseInsensitive))
+        unit = 1000;
+    else if (value.endsWith('M', Qt::CaseInsensitive))
+        unit = 1000 * 1000;
+    if (unit != 1)
+        value.chop(1);
+    return value.toLongLong() * unit;
+}
+
+// Throughput in MB/s of payload bytes.
+double
+measure(qsizetype payload, int iterations, const std::function<qsizetype()>& op)
+{
+    qsizetype sink = 0;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < iterations; ++i)
+        sink += op();
+    auto seconds = timer.nsecsElapsed() / 1e9;
+    // Keeps the results observable.
+    if (sink < 0)
+        printf("%lld\n", static_cast<long long>(sink));
+    return payload * static_cast<double>(iterations) / seconds / 1e6;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Base64 codec microbenchmark");
+    parser.addHelpOption();
+    QCommandLineOption sizesOption("sizes",
+                                   "Comma separated payload sizes (K and M suffixes).",
+                                   "sizes",
+                                   "10K,100K,1M,5M");
+    QCommandLineOption iterationsOption("iterations", "Round trips per size.", "count", "50");
+    parser.addOptions({sizesOption, iterationsOption});
+    parser.process(app);
+
+    auto iterations = std::max(1, parser.value(iterationsOption).toInt());
+
+    printf("%10s  %14s  %14s  %14s  %14s\n",
+           "payload",
+           "Qt decode",
+           "Base64 decode",
+           "Qt encode",
+           "Base64 encode");
+    for (const auto& value : parser.value(sizesOption).split(',')) {
+        auto size = parseSize(value);
+        if (size <= 0)
+            continue;
+
+        QByteArray payload(size, Qt::Uninitialized);
+        QRandomGenerator generator(size);
+        for (auto& byte : payload)
+            byte = char(generator.generate());
+        auto text = QString::fromLatin1(payload.toBase64());
+
+        auto qtDecode = measure(size, iterations, [&] {
+            return QByteArray::fromBase64(text.toLatin1()).size();
+        });
+        auto decode = measure(size, iterations, [&] { return Base64::decode(text).size(); });
+        auto qtEncode = measure(size, iterations, [&] {
+            return QString::fromLatin1(payload.toBase64()).size();
+        });
+        auto encode = measure(size, iterations, [&] {
+            return Base64::encodeToString(payload).size();
+        });
+        if (Base64::decode(text) != payload) {
+            qCritical() << "Decoded payload mismatch for size" << size;
+            return 1;
+        }
+
+        printf("%10s  %9.0f MB/s  %9.0f MB/s  %9.0f MB/s  %9.0f MB/s\n",
+               qPrintable(value),
+               qtDecode,
+               decode,
+               qtEncode,
+               encode);
+    }
+
+    return 0;
+}
@@ -0,0 +1,367 @@
+/*
+ * Copyright (C) 2022 Savoir-faire Linux Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Headless VideoProvider throughput benchmark.
+ *
+ * A synthetic VideoSource stands in for AVModel: one producer thread per
+ * renderer publishes frames at a fixed rate, through the direct renderer
+ * path (frameBufferRequested/frameUpdated) or the shared memory path
+ * (frameUpdated/getRendererFrame). Every frame is tagged with a sequence
+ * number, repeated over its first rows so that it survives the box
+ * downscale, to measure the delivery latency to offscreen QVideoSinks.
+ *
+ * Example:
+ *   videoprovider_benchmark --resolution 1080p --renderers 9 --sinks 2 --duration 10
+ */
+
+#include "videoprovider.h"
+#include "videoscaler.h"
+
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QTimer>
+#include <QVideoSink>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Rows of the frame carrying the sequence number tag.
+constexpr int kTagRows = VideoScaler::kMaxFactor;
+// Publication timestamps are kept for the last kSlots frames.
+constexpr int kSlots = 1024;
+
+QElapsedTimer clock_;
+
+void
+writeTag(uchar* data, int bytesPerLine, int width, int height, quint32 seq)
+{
+    for (int y = 0; y < std::min(kTagRows, height); ++y) {
+        auto row = reinterpret_cast<quint32*>(data + static_cast<qsizetype>(y) * bytesPerLine);
+        std::fill(row, row + width, seq);
+    }
+}
+
+quint32
+readTag(const QVideoFrame& frame)
+{
+    QVideoFrame copy(frame);
+    if (!copy.map(QVideoFrame::ReadOnly)) {
+        return 0;
+    }
+    quint32 seq;
+    std::memcpy(&seq, copy.bits(0), sizeof(seq));
+    copy.unmap();
+    return seq;
+}
+
+class SyntheticVideoSource final : public VideoSource
+{
+public:
+    struct Renderer
+    {
+        QString id;
+        std::thread thread;
+        std::vector<uint8_t> shm[2];
+        int shmIndex {0};
+        std::atomic<quint32> lastSeq {0};
+        std::unique_ptr<std::atomic<qint64>[]> publishTimes;
+    };
+
+    SyntheticVideoSource(const QSize& size, bool directRenderer, bool fill)
+        : size_(size)
+        , directRenderer_(directRenderer)
+        , fill_(fill)
+    {}
+
+    ~SyntheticVideoSource()
+    {
+        stop();
+    }
+
+    QSize getRendererSize(const QString&) override
+    {
+        return size_;
+    }
+    bool useDirectRenderer() const override
+    {
+        return directRenderer_;
+    }
+    lrc::api::video::Frame getRendererFrame(const QString& id) override
+    {
+        // Called from onFrameUpdated, on the producer thread.
+        auto& renderer = *renderers_.at(indexes_.value(id));
+        auto& shm = renderer.shm[renderer.shmIndex];
+        lrc::api::video::Frame frame;
+        frame.ptr = shm.data();
+        frame.size = shm.size();
+        return frame;
+    }
+
+    Renderer& addRenderer(const QString& id)
+    {
+        auto renderer = std::make_unique<Renderer>();
+        renderer->id = id;
+        renderer->publishTimes.reset(new std::atomic<qint64>[kSlots]);
+        if (!directRenderer_) {
+            for (auto& shm : renderer->shm) {
+                shm.resize(static_cast<size_t>(size_.width()) * size_.height() * 4);
+            }
+        }
+        indexes_.insert(id, static_cast<int>(renderers_.size()));
+        renderers_.emplace_back(std::move(renderer));
+        Q_EMIT rendererStarted(id);
+        return *renderers_.back();
+    }
+
+    Renderer& renderer(const QString& id)
+    {
+        return *renderers_.at(indexes_.value(id));
+    }
+
+    const std::vector<std::unique_ptr<Renderer>>& renderers() const
+    {
+        return renderers_;
+    }
+
+    void start(int fps)
+    {
+        running_ = true;
+        for (auto& renderer : renderers_) {
+            renderer->thread = std::thread([this, r = renderer.get(), fps] { produce(*r, fps); });
+        }
+    }
+
+    void stop()
+    {
+        running_ = false;
+        for (auto& renderer : renderers_) {
+            if (renderer->thread.joinable()) {
+                renderer->thread.join();
+            }
+        }
+    }
+
+private:
+    void produce(Renderer& renderer, int fps)
+    {
+        const auto period = std::chrono::nanoseconds(1000000000 / fps);
+        auto next = std::chrono::steady_clock::now();
+        for (quint32 seq = 1; running_; ++seq) {
+            if (directRenderer_) {
+                AVFrame avframe {};
+                Q_EMIT frameBufferRequested(renderer.id, &avframe);
+                if (!avframe.data[0]) {
+                    continue;
+                }
+                if (fill_) {
+                    std::memset(avframe.data[0],
+                                seq & 0xff,
+                                static_cast<size_t>(avframe.linesize[0]) * avframe.height);
+                }
+                writeTag(avframe.data[0], avframe.linesize[0], avframe.width, avframe.height, seq);
+            } else {
+                renderer.shmIndex ^= 1;
+                auto& shm = renderer.shm[renderer.shmIndex];
+                if (fill_) {
+                    std::memset(shm.data(), seq & 0xff, shm.size());
+                }
+                writeTag(shm.data(), size_.width() * 4, size_.width(), size_.height(), seq);
+            }
+            renderer.publishTimes[seq % kSlots] = clock_.nsecsElapsed();
+            renderer.lastSeq = seq;
+            Q_EMIT frameUpdated(renderer.id);
+
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+    }
+
+    QSize size_;
+    bool directRenderer_;
+    bool fill_;
+    std::atomic_bool running_ {false};
+    std::vector<std::unique_ptr<Renderer>> renderers_;
+    QHash<QString, int> indexes_;
+};
+
+QSize
+parseResolution(const QString& value)
+{
+    static const QHash<QString, QSize> presets {{"480p", {854, 480}},
+                                                {"720p", {1280, 720}},
+                                                {"1080p", {1920, 1080}},
+                                                {"4k", {3840, 2160}}};
+    auto it = presets.constFind(value.toLower());
+    if (it != presets.cend()) {
+        return it.value();
+    }
+    auto parts = value.split('x');
+    if (parts.size() == 2) {
+        return {parts[0].toInt(), parts[1].toInt()};
+    }
+    return {};
+}
+
+qint64
+percentile(std::vector<qint64>& values, double p)
+{
+    if (values.empty()) {
+        return 0;
+    }
+    auto n = static_cast<size_t>(p * (values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + n, values.end());
+    return values[n];
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless VideoProvider throughput benchmark");
+    parser.addHelpOption();
+    QCommandLineOption resolutionOption("resolution",
+                                        "480p, 720p, 1080p, 4k or WxH.",
+                                        "resolution",
+                                        "1080p");
+    QCommandLineOption renderersOption("renderers", "Renderer count (1-25).", "count", "4");
+    QCommandLineOption sinksOption("sinks", "Sinks per renderer.", "count", "1");
+    QCommandLineOption sinkSizeOption("sink-size",
+                                      "On-screen sink size (WxH), full size if unset.",
+                                      "size");
+    QCommandLineOption fpsOption("fps", "Frames per second per renderer.", "fps", "30");
+    QCommandLineOption durationOption("duration", "Duration in seconds.", "seconds", "10");
+    QCommandLineOption poolOption("pool", "Frames per renderer (3-4).", "count", "3");
+    QCommandLineOption shmOption("shm", "Use the shared memory renderer path.");
+    QCommandLineOption fillOption("fill", "Write every frame entirely, like a decoder.");
+    parser.addOptions({resolutionOption,
+                       renderersOption,
+                       sinksOption,
+                       sinkSizeOption,
+                       fpsOption,
+                       durationOption,
+                       poolOption,
+                       shmOption,
+                       fillOption});
+    parser.process(app);
+
+    auto resolution = parseResolution(parser.value(resolutionOption));
+    auto rendererCount = std::clamp(parser.value(renderersOption).toInt(), 1, 25);
+    auto sinkCount = std::max(1, parser.value(sinksOption).toInt());
+    auto sinkSize = parseResolution(parser.value(sinkSizeOption));
+    auto fps = std::max(1, parser.value(fpsOption).toInt());
+    auto duration = std::max(1, parser.value(durationOption).toInt());
+    if (resolution.isEmpty()) {
+        qCritical() << "Invalid resolution" << parser.value(resolutionOption);
+        return 1;
+    }
+
+    clock_.start();
+    SyntheticVideoSource source(resolution, !parser.isSet(shmOption), parser.isSet(fillOption));
+    VideoProvider provider(source);
+    provider.setFramePoolSize(parser.value(poolOption).toInt());
+
+    std::vector<std::unique_ptr<QVideoSink>> sinks;
+    std::vector<qint64> latencies;
+    latencies.reserve(static_cast<size_t>(rendererCount) * sinkCount * fps * duration);
+    quint64 delivered = 0;
+
+    for (int r = 0; r < rendererCount; ++r) {
+        auto id = QString("renderer%1").arg(r);
+        for (int s = 0; s < sinkCount; ++s) {
+            auto sink = std::make_unique<QVideoSink>();
+            provider.registerSink(id, sink.get(), sinkSize);
+            // The provider may notify twice per frame, only count new tags.
+            auto lastSeq = std::make_shared<quint32>(0);
+            QObject::connect(sink.get(),
+                             &QVideoSink::videoFrameChanged,
+                             &app,
+                             [&, id, lastSeq](const QVideoFrame& frame) {
+                                 auto now = clock_.nsecsElapsed();
+                                 auto seq = readTag(frame);
+                                 if (seq == 0 || seq == *lastSeq) {
+                                     return;
+                                 }
+                                 *lastSeq = seq;
+                                 auto& renderer = source.renderer(id);
+                                 if (renderer.lastSeq - seq >= kSlots) {
+                                     return;
+                                 }
+                                 latencies.push_back(now - renderer.publishTimes[seq % kSlots]);
+                                 ++delivered;
+                             });
+            sinks.emplace_back(std::move(sink));
+        }
+        source.addRenderer(id);
+    }
+
+    auto cpuStart = std::clock();
+    QElapsedTimer wallClock;
+    wallClock.start();
+    source.start(fps);
+
+    QTimer::singleShot(duration * 1000, &app, [&] {
+        source.stop();
+        auto wall = wallClock.nsecsElapsed() / 1e9;
+        auto cpu = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+
+        quint64 published = 0;
+        quint64 dropped = 0;
+        for (const auto& renderer : source.renderers()) {
+            published += renderer->lastSeq;
+            dropped += provider.rendererStats(renderer->id)["framesDropped"].toULongLong();
+        }
+
+        auto p50 = percentile(latencies, 0.5);
+        auto p99 = percentile(latencies, 0.99);
+        printf("resolution %dx%d, %d renderer(s), %d sink(s) each, %s path, %ds\n",
+               resolution.width(),
+               resolution.height(),
+               rendererCount,
+               sinkCount,
+               parser.isSet(shmOption) ? "shm" : "direct",
+               duration);
+        printf("published %llu, delivered %llu, dropped %llu\n",
+               static_cast<unsigned long long>(published),
+               static_cast<unsigned long long>(delivered),
+               static_cast<unsigned long long>(dropped));
+        printf("delivered fps per sink: %.1f\n", delivered / wall / (rendererCount * sinkCount));
+        printf("latency p50: %.3f ms, p99: %.3f ms\n", p50 / 1e6, p99 / 1e6);
+        printf("cpu per delivered frame: %.1f us (%.1f%% of one core)\n",
+               delivered ? cpu * 1e6 / delivered : 0.,
+               cpu * 100. / wall);
+        app.quit();
+    });
+
+    return app.exec();
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2022 Savoir-faire Linux Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "base64.h"
+
+#include <QRandomGenerator>
+
+#include <gtest/gtest.h>
+
+/*!
+ * Test fixture for the base64 codec, compared to QByteArray's.
+ */
+class Base64Fixture : public ::testing::Test
+{
+public:
+    static QByteArray randomBytes(qsizetype size, quint32 seed)
+    {
+        QRandomGenerator generator(seed);
+        QByteArray bytes(size, Qt::Uninitialized);
+        for (auto& byte : bytes)
+            byte = char(generator.generate());
+        return bytes;
+    }
+};
+
+/*!
+ * WHEN  encoding bytes of every length modulo 3, around the block size
+ * THEN  the result should match QByteArray::toBase64, as bytes and text.
+ */
+TEST_F(Base64Fixture, EncodeMatchesQt)
+{
+    for (qsizetype size = 0; size < 100; ++size) {
+        auto bytes = randomBytes(size, size);
+        EXPECT_EQ(Base64::encode(bytes), bytes.toBase64()) << "size " << size;
+        EXPECT_EQ(Base64::encodeToString(bytes), QString::fromLatin1(bytes.toBase64()))
+            << "size " << size;
+    }
+}
+
+/*!
+ * WHEN  decoding base64 text, with and without characters outside of
+ *       the alphabet spread in it
+ * THEN  the result should match QByteArray::fromBase64, from bytes and
+ *       from UTF-16 text.
+ */
+TEST_F(Base64Fixture, DecodeMatchesQt)
+{
+    for (qsizetype size = 0; size < 100; ++size) {
+        auto encoded = randomBytes(size, size).toBase64();
+        for (bool noisy : {false, true}) {
+            auto input = encoded;
+            if (noisy) {
+                QRandomGenerator generator(size);
+                for (int i = 0; i < 4; ++i)
+                    input.insert(generator.bounded(input.size() + 1), "\n =\x80"[i]);
+            }
+            auto expected = QByteArray::fromBase64(input);
+            EXPECT_EQ(Base64::decode(input), expected) << "size " << size;
+            EXPECT_EQ(Base64::decode(QString::fromLatin1(input)), expected) << "size " << size;
+        }
+    }
+}
+
+/*!
+ * WHEN  decoding UTF-16 text containing characters above Latin-1
+ * THEN  they should be skipped like any character outside of the alphabet.
+ */
+TEST_F(Base64Fixture, DecodeSkipsWideCharacters)
+{
+    auto bytes = randomBytes(60, 1);
+    auto text = QString::fromLatin1(bytes.toBase64());
+    text.insert(5, QChar(0x141));
+    text.insert(40, QChar(0x2f41));
+    EXPECT_EQ(Base64::decode(text), bytes);
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2022 Savoir-faire Linux Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "conversationsearchindex.h"
+
+#include <gtest/gtest.h>
+
+/*!
+ * Test fixture for the conversation search index, checked against a
+ * linear scan of the same fields.
+ */
+class ConversationSearchIndexFixture : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        items_ = {{"a", {"Alice Martin", "7f3c2a", "alice", "alice.m"}},
+                  {"b", {"Bob", "e91b00", "", "bobby"}},
+                  {"c", {"Team Martinique", "7f3c2a", "Alice Martin", "e91b00", "Bob"}},
+                  {"d", {"Ölaf", "ab12cd", "OLAF", ""}}};
+        for (auto it = items_.cbegin(); it != items_.cend(); ++it)
+            index_.insert(it.key(), it.value());
+    }
+
+    void expectSameAsScan(const QString& text)
+    {
+        auto needle = ConversationSearchIndex::normalize(text);
+        for (auto it = items_.cbegin(); it != items_.cend(); ++it) {
+            bool expected = false;
+            for (const auto& field : it.value())
+                expected |= ConversationSearchIndex::normalize(field).contains(needle);
+            EXPECT_EQ(index_.matches(it.key(), needle), expected)
+                << "text " << text.toStdString() << " item " << it.key().toStdString();
+        }
+    }
+
+    QMap<QString, QStringList> items_;
+    ConversationSearchIndex index_;
+};
+
+/*!
+ * WHEN  searching texts typed character by character, pasted, or
+ *       spanning two fields
+ * THEN  the matches should be those of a linear scan.
+ */
+TEST_F(ConversationSearchIndexFixture, MatchesLinearScan)
+{
+    for (const auto& text : {"", "m", "ma", "mar", "mart", "martin", "martini", "b", "bo",
+                             "bob", "BOB", "7f3", "e91b", "alice.m", "ölaf", "OLAF", "xyz",
+                             "martinbob", "in alice"})
+        expectSameAsScan(QString::fromUtf8(text));
+}
+
+/*!
+ * WHEN  inserting, updating and removing items after a search
+ * THEN  the result of that search should be updated with them.
+ */
+TEST_F(ConversationSearchIndexFixture, UpdatesLastSearch)
+{
+    auto needle = ConversationSearchIndex::normalize("martin");
+    EXPECT_TRUE(index_.matches("a", needle));
+    EXPECT_FALSE(index_.matches("b", needle));
+
+    items_["b"] = QStringList {"Bob Martin", "e91b00"};
+    index_.insert("b", items_["b"]);
+    EXPECT_TRUE(index_.matches("b", needle));
+
+    items_.remove("a");
+    index_.remove("a");
+    EXPECT_FALSE(index_.contains("a"));
+    EXPECT_FALSE(index_.matches("a", needle));
+
+    items_["e"] = QStringList {"martine"};
+    index_.insert("e", items_["e"]);
+    EXPECT_TRUE(index_.matches("e", needle));
+    EXPECT_EQ(index_.size(), 4);
+
+    expectSameAsScan("mart");
+    expectSameAsScan("bob");
+}
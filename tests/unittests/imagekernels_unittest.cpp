@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2022 Savoir-faire Linux Inc.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "imagekernels.h"
+
+#include <QPainter>
+#include <QRandomGenerator>
+
+#include <gtest/gtest.h>
+
+/*!
+ * Test fixture for the avatar compositing kernels, compared to the
+ * QPainter compositions they replace.
+ */
+class ImageKernelsFixture : public ::testing::Test
+{
+public:
+    // Semi-transparent noise, so that every channel and coverage value
+    // goes through the kernels.
+    static QImage noise(const QSize& size, quint32 seed)
+    {
+        QRandomGenerator generator(seed);
+        QImage image(size, QImage::Format_ARGB32);
+        for (int y = 0; y < size.height(); ++y) {
+            auto line = reinterpret_cast<quint32*>(image.scanLine(y));
+            for (int x = 0; x < size.width(); ++x)
+                line[x] = generator.generate();
+        }
+        return image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    }
+
+    static QImage painterCircleCrop(const QImage& photo, int size, int margin)
+    {
+        QImage target(size, size, QImage::Format_ARGB32_Premultiplied);
+        target.fill(Qt::transparent);
+        QPainter painter(&target);
+        painter.setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform);
+        painter.setBrush(QBrush(Qt::white));
+        painter.drawEllipse(0, 0, size, size);
+        painter.setCompositionMode(QPainter::CompositionMode_SourceIn);
+        painter.drawImage(0, 0, photo, margin, 0);
+        return target;
+    }
+
+    static QImage painterHalfCrop(const QImage& original, bool leftSide)
+    {
+        auto width = original.size().width();
+        auto height = original.size().height();
+        QImage target(width, height, QImage::Format_ARGB32_Premultiplied);
+        target.fill(Qt::transparent);
+        QPainter painter(&target);
+        painter.setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform);
+        painter.setBrush(QBrush(Qt::white));
+        painter.drawRect(leftSide ? 0 : width / 2 + 2, 0, width / 2 - (leftSide ? 2 : 0), height);
+        painter.setCompositionMode(QPainter::CompositionMode_SourceIn);
+        painter.drawImage(0, 0, original, 0, 0);
+        return target;
+    }
+
+    static QImage painterSplitCrop(const QImage& left, const QImage& right)
+    {
+        QImage avatar(left.size(), QImage::Format_ARGB32_Premultiplied);
+        avatar.fill(Qt::transparent);
+        QPainter painter(&avatar);
+        painter.setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform);
+        painter.drawImage(avatar.rect(), painterHalfCrop(left, true));
+        painter.drawImage(avatar.rect(), painterHalfCrop(right, false));
+        return avatar;
+    }
+
+    // Number of pixels differing between two images of the same size.
+    static int diff(const QImage& a, const QImage& b)
+    {
+        if (a.size() != b.size())
+            return -1;
+        auto ia = a.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        auto ib = b.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        int count = 0;
+        for (int y = 0; y < ia.height(); ++y) {
+            auto la = reinterpret_cast<const quint32*>(ia.constScanLine(y));
+            auto lb = reinterpret_cast<const quint32*>(ib.constScanLine(y));
+            for (int x = 0; x < ia.width(); ++x)
+                count += la[x] != lb[x];
+        }
+        return count;
+    }
+};
+
+/*!
+ * WHEN  A photo is cut in a circle, with and without horizontal margin.
+ * THEN  The kernel output should match QPainter's pixel for pixel.
+ */
+TEST_F(ImageKernelsFixture, CircleCropMatchesPainter)
+{
+    for (int size : {1, 7, 24, 48, 57, 128}) {
+        for (int margin : {0, 3}) {
+            auto photo = noise(QSize(size + 2 * margin, size + 1), size);
+            EXPECT_EQ(diff(ImageKernels::circleCrop(photo, size, margin),
+                           painterCircleCrop(photo, size, margin)),
+                      0)
+                << "size " << size << " margin " << margin;
+        }
+    }
+}
+
+/*!
+ * WHEN  An image is cut in half, on either side.
+ * THEN  The kernel output should match QPainter's pixel for pixel.
+ */
+TEST_F(ImageKernelsFixture, HalfCropMatchesPainter)
+{
+    for (int size : {5, 24, 49, 128}) {
+        auto image = noise(QSize(size, size), size);
+        for (bool leftSide : {true, false}) {
+            EXPECT_EQ(diff(ImageKernels::halfCrop(image, leftSide),
+                           painterHalfCrop(image, leftSide)),
+                      0)
+                << "size " << size << " left " << leftSide;
+        }
+    }
+}
+
+/*!
+ * WHEN  Two avatars are combined in a two-up split.
+ * THEN  The kernel output should match QPainter's pixel for pixel.
+ */
+TEST_F(ImageKernelsFixture, SplitCropMatchesPainter)
+{
+    for (int size : {5, 24, 49, 128}) {
+        auto left = noise(QSize(size, size), size);
+        auto right = noise(QSize(size, size), size + 1);
+        EXPECT_EQ(diff(ImageKernels::splitCrop(left, right), painterSplitCrop(left, right)), 0)
+            << "size " << size;
+    }
+}